@@ -0,0 +1,199 @@
+#include "async.h"
+
+#include <algorithm>
+#include <bit>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#ifndef EMSCRIPTEN
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#include <fmt/format.h>
+
+#include "backends/backend.h"
+
+namespace ImChart::Async {
+
+namespace {
+
+// Recycled coroutine frames, frames can be freed on another thread than they were allocated on
+constexpr int MIN_CLASS = 6;  // 64 bytes
+constexpr int MAX_CLASS = 16; // 64 kB, bigger frames go straight to operator new
+
+struct FreeFrame {
+    FreeFrame *next;
+};
+
+std::mutex  g_framesMutex;
+FreeFrame  *g_freeFrames[MAX_CLASS + 1] = {};
+
+int         sizeClassFor(size_t size) {
+    return std::max(MIN_CLASS, int(std::bit_width(size - 1)));
+}
+
+} // namespace
+
+void *Task::promise_type::operator new(size_t size) {
+    const int cls = sizeClassFor(size);
+    if (cls > MAX_CLASS) {
+        return ::operator new(size);
+    }
+    {
+        std::lock_guard lock(g_framesMutex);
+        if (auto frame = g_freeFrames[cls]) {
+            g_freeFrames[cls] = frame->next;
+            return frame;
+        }
+    }
+    return ::operator new(size_t(1) << cls);
+}
+
+void Task::promise_type::operator delete(void *ptr, size_t size) {
+    const int cls = sizeClassFor(size);
+    if (cls > MAX_CLASS) {
+        ::operator delete(ptr);
+        return;
+    }
+    std::lock_guard lock(g_framesMutex);
+    auto            frame = static_cast<FreeFrame *>(ptr);
+    frame->next           = g_freeFrames[cls];
+    g_freeFrames[cls]     = frame;
+}
+
+void Task::promise_type::unhandled_exception() noexcept {
+    fmt::print(stderr, "Unhandled exception in an Async::Task.\n");
+    std::terminate();
+}
+
+void ResumeOnPool::await_suspend(std::coroutine_handle<> handle) const {
+    Backend::threadPool().submit(name, [handle]() { handle.resume(); });
+}
+
+void ResumeOnUiThread::await_suspend(std::coroutine_handle<> handle) const {
+    Backend::instance().post([handle]() { handle.resume(); });
+}
+
+void Sleep::await_suspend(std::coroutine_handle<> handle) const {
+    Backend::instance().postDelayed([handle]() { handle.resume(); }, delay);
+}
+
+#ifndef EMSCRIPTEN
+
+namespace {
+
+/**
+ * Thread polling the descriptors awaited by coroutines. Every wait is one-shot: once the
+ * descriptor is ready the waiting coroutine is posted to the UI thread and the entry removed.
+ */
+class FdWatcher {
+public:
+    static FdWatcher &instance() {
+        static FdWatcher watcher;
+        return watcher;
+    }
+
+    void add(FdReady *awaiter, std::coroutine_handle<> handle) {
+        {
+            std::lock_guard lock(m_mutex);
+            m_waits.push_back({ awaiter, handle });
+        }
+        wake();
+    }
+
+private:
+    struct Wait {
+        FdReady                *awaiter;
+        std::coroutine_handle<> handle;
+    };
+
+    FdWatcher() {
+        if (::pipe(m_wakePipe) != 0) {
+            fmt::print(stderr, "Unable to create the wake up pipe of the descriptor watcher.\n");
+            m_wakePipe[0] = m_wakePipe[1] = -1;
+        }
+        ::fcntl(m_wakePipe[0], F_SETFL, O_NONBLOCK);
+        m_thread = std::thread([this]() { run(); });
+    }
+
+    ~FdWatcher() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_quit = true;
+        }
+        wake();
+        m_thread.join();
+        ::close(m_wakePipe[0]);
+        ::close(m_wakePipe[1]);
+    }
+
+    void wake() {
+        const char c = 0;
+        [[maybe_unused]] auto r = ::write(m_wakePipe[1], &c, 1);
+    }
+
+    void run() {
+        std::vector<pollfd> fds;
+        std::vector<Wait>   waits;
+        for (;;) {
+            {
+                std::lock_guard lock(m_mutex);
+                if (m_quit) {
+                    return;
+                }
+                waits = m_waits;
+            }
+            fds.clear();
+            fds.push_back({ m_wakePipe[0], POLLIN, 0 });
+            for (const auto &w : waits) {
+                fds.push_back({ w.awaiter->fd, short(w.awaiter->write ? POLLOUT : POLLIN), 0 });
+            }
+
+            if (::poll(fds.data(), fds.size(), -1) < 0) {
+                continue; // EINTR
+            }
+            if (fds[0].revents) {
+                char buffer[64];
+                while (::read(m_wakePipe[0], buffer, sizeof(buffer)) > 0) {
+                }
+            }
+
+            std::lock_guard lock(m_mutex);
+            for (size_t i = 0; i < waits.size(); ++i) {
+                const auto revents = fds[i + 1].revents;
+                if (!revents) {
+                    continue;
+                }
+                auto it = std::find_if(m_waits.begin(), m_waits.end(), [&](const Wait &w) { return w.handle == waits[i].handle; });
+                if (it == m_waits.end()) {
+                    continue;
+                }
+                // a hang up with data left to read still counts as readable
+                it->awaiter->ok = (revents & (POLLIN | POLLOUT)) && !(revents & (POLLERR | POLLNVAL));
+                Backend::instance().post([handle = it->handle]() { handle.resume(); });
+                m_waits.erase(it);
+            }
+        }
+    }
+
+    int               m_wakePipe[2];
+    std::mutex        m_mutex;
+    std::vector<Wait> m_waits;
+    bool              m_quit = false;
+    std::thread       m_thread;
+};
+
+} // namespace
+
+void FdReady::await_suspend(std::coroutine_handle<> handle) {
+    FdWatcher::instance().add(this, handle);
+}
+
+#endif
+
+} // namespace ImChart::Async
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+
+namespace ImChart::Async {
+
+/**
+ * Coroutine support, to write multi-step data sources without callbacks and without blocking the
+ * UI thread:
+ *
+ *     Async::Task acquire(MyDataSet &ds) {
+ *         for (;;) {
+ *             co_await Async::readable(socket);          // resumes on the UI thread
+ *             co_await Async::resumeOnPool("decode");    // moves to the thread pool
+ *             auto block = decode(socket);
+ *             co_await Async::resumeOnUiThread();
+ *             ds.append(block);                          // dataChanged() on the UI thread
+ *         }
+ *     }
+ *
+ * A Task starts right away and destroys itself when it returns. It must not outlive the objects
+ * it uses. All awaitables except resumeOnPool() resume on the UI thread.
+ *
+ * The coroutine frames are recycled in size classes, so a data source started over and over
+ * again does not allocate its frames once warmed up. The awaitables do allocate: resuming on the
+ * pool, on the UI thread or after a sleep() hands a callback to the backend on every suspension.
+ */
+class Task {
+public:
+    struct promise_type {
+        Task                get_return_object() noexcept { return {}; }
+        std::suspend_never  initial_suspend() noexcept { return {}; }
+        std::suspend_never  final_suspend() noexcept { return {}; }
+        void                return_void() noexcept {}
+        void                unhandled_exception() noexcept;
+
+        static void        *operator new(size_t size);
+        static void         operator delete(void *ptr, size_t size);
+    };
+};
+
+struct ResumeOnPool {
+    const char *name;
+
+    bool        await_ready() const noexcept { return false; }
+    void        await_suspend(std::coroutine_handle<> handle) const;
+    void        await_resume() const noexcept {}
+};
+
+struct ResumeOnUiThread {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) const;
+    void await_resume() const noexcept {}
+};
+
+struct Sleep {
+    std::chrono::milliseconds delay;
+
+    bool                      await_ready() const noexcept { return false; }
+    void                      await_suspend(std::coroutine_handle<> handle) const;
+    void                      await_resume() const noexcept {}
+};
+
+// Continues on the thread pool, accounting the time until the next suspension under 'name'
+inline ResumeOnPool     resumeOnPool(const char *name = nullptr) { return { name }; }
+// Continues on the UI thread, from the event loop
+inline ResumeOnUiThread resumeOnUiThread() { return {}; }
+// Continues on the UI thread once the delay elapsed
+inline Sleep            sleep(std::chrono::milliseconds delay) { return { delay }; }
+
+#ifndef EMSCRIPTEN
+
+struct FdReady {
+    int  fd;
+    bool write;
+    bool ok = false;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle);
+    // false if the descriptor reported an error or a hang up instead
+    bool await_resume() const noexcept { return ok; }
+};
+
+// Continues on the UI thread once data can be read from the file descriptor, e.g. a socket
+inline FdReady readable(int fd) { return { fd, false }; }
+// Continues on the UI thread once the file descriptor accepts writes
+inline FdReady writable(int fd) { return { fd, true }; }
+
+#endif
+
+} // namespace ImChart::Async
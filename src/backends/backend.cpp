@@ -1,5 +1,10 @@
 #include "backend.h"
 
+#include <algorithm>
+#include <thread>
+
+#include <imgui.h>
+
 #include "glfw/glfwbackend.h"
 #include "sdl/sdlbackend.h"
 
@@ -21,4 +26,18 @@ Backend &instance() {
     return *g_backend;
 }
 
+ImFontAtlas &sharedFontAtlas() {
+    // never destroyed, like the ImGui contexts using it
+    static auto atlas = []() {
+        ImGuiAllocator::install();
+        return IM_NEW(ImFontAtlas);
+    }();
+    return *atlas;
+}
+
+ThreadPool &threadPool() {
+    static ThreadPool pool(int(std::max(2u, std::thread::hardware_concurrency())) - 1);
+    return pool;
+}
+
 } // namespace ImChart::Backend
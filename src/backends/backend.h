@@ -1,10 +1,16 @@
 #pragma once
 
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <type_traits>
 
+#include "imguiallocator.h"
+#include "threadpool.h"
 #include "utils.h"
 
+struct ImFontAtlas;
+
 namespace ImChart {
 
 class Window;
@@ -16,33 +22,64 @@ class Window;
 
 class Backend {
 public:
-    virtual ~Backend()                                                                  = default;
+    virtual ~Backend()                                                                                    = default;
+
+    virtual void                    run()                                                                 = 0;
 
-    virtual void                    run()                                               = 0;
+    virtual void                   *nativeDisplay()                                                       = 0;
 
-    virtual void                   *nativeDisplay()                                     = 0;
+    virtual std::unique_ptr<Window> createWindow(ImChart::Window *window, int w, int h)                   = 0;
 
-    virtual std::unique_ptr<Window> createWindow(ImChart::Window *window, int w, int h) = 0;
+    virtual void                    scheduleRender(ImChart::Window *window)                               = 0;
 
-    virtual void                    scheduleRender(ImChart::Window *window)             = 0;
+    virtual void                    startTimer(Timer *t)                                                  = 0;
 
-    virtual void                    startTimer(Timer *t)                                = 0;
+    // Queues the function to be run on the UI thread. Can be called from any thread. Returns false
+    // if the event queue is full, the function is dropped then.
+    virtual bool                    post(std::function<void()> f)                                         = 0;
+    // Like post(), once the delay elapsed
+    virtual void                    postDelayed(std::function<void()> f, std::chrono::milliseconds delay) = 0;
 };
 
 class Window {
 public:
-    virtual ~Window()                   = default;
+    virtual ~Window()                                    = default;
+
+    virtual void                 *nativeWindow()         = 0;
 
-    virtual void *nativeWindow()        = 0;
+    virtual void                  show()                 = 0;
+    virtual void                  setSize(int w, int h)  = 0;
 
-    virtual void  show()                = 0;
-    virtual void  setSize(int w, int h) = 0;
+    virtual Size                  pixelSize() const      = 0;
 
-    virtual Size  pixelSize() const     = 0;
+    virtual const AllocatorStats &allocatorStats() const = 0;
 };
 
-bool     create();
-Backend &instance();
+bool         create();
+Backend     &instance();
+
+// The font atlas shared by the ImGui contexts of all windows, so the fonts are built and uploaded once
+ImFontAtlas &sharedFontAtlas();
+
+// The pool running the background work of the application, with one worker less than the cores
+// as the UI thread takes part in parallelFor()
+ThreadPool  &threadPool();
+
+/**
+ * Runs 'work' on the thread pool, then 'then' on the UI thread, with the result of 'work' unless
+ * it returns void. Both must be copyable.
+ */
+template<typename Work, typename Then>
+void async(const char *name, Work work, Then then) {
+    threadPool().submit(name, [work = std::move(work), then = std::move(then)]() mutable {
+        if constexpr (std::is_void_v<std::invoke_result_t<Work &>>) {
+            work();
+            instance().post(std::move(then));
+        } else {
+            instance().post([then = std::move(then), result = work()]() mutable { then(std::move(result)); });
+        }
+    });
+}
 
 } // namespace Backend
 
@@ -20,6 +20,7 @@
 #include <implot.h>
 
 #include "renderers/renderer.h"
+#include "startup.h"
 #include "timer.h"
 #include "window.h"
 
@@ -59,7 +60,10 @@ std::unique_ptr<Window> GLFWBackend::createWindow(ImChart::Window *window, int w
     auto w     = std::make_unique<GLFWWindow>();
     w->m_win   = win;
 
-    w->m_imgui = ImGui::CreateContext();
+    ImGuiAllocator::install();
+    ImGuiAllocator::setCurrentStats(&w->m_allocatorStats);
+
+    w->m_imgui  = ImGui::CreateContext(&sharedFontAtlas());
     w->m_implot = ImPlot::CreateContext();
     ImGui::SetCurrentContext(w->m_imgui);
     ImPlot::SetCurrentContext(w->m_implot);
@@ -68,12 +72,15 @@ std::unique_ptr<Window> GLFWBackend::createWindow(ImChart::Window *window, int w
     (void) io;
     // io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
     // io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
+    // Keep the transient buffers of idle windows around instead of freeing and regrowing them
+    io.ConfigMemoryCompactTimer = -1.0f;
 
     // Setup Dear ImGui style
     ImGui::StyleColorsDark();
     // ImGui::StyleColorsLight();
 
     ImGui_ImplGlfw_InitForOther(win, true);
+    ImGuiAllocator::setCurrentStats(nullptr);
 
     return w;
 }
@@ -98,6 +105,22 @@ void GLFWBackend::startTimer(Timer *timer) {
     t.detach();
 }
 
+bool GLFWBackend::post(std::function<void()> f) {
+    m_timersMutex.lock();
+    m_posted.push_back(std::move(f));
+    m_timersMutex.unlock();
+    glfwPostEmptyEvent();
+    return true;
+}
+
+void GLFWBackend::postDelayed(std::function<void()> f, std::chrono::milliseconds delay) {
+    std::thread t([this, f = std::move(f), delay]() mutable {
+        std::this_thread::sleep_for(delay);
+        post(std::move(f));
+    });
+    t.detach();
+}
+
 void GLFWBackend::iterate() {
 #ifdef EMSCRIPTEN
     glfwPollEvents();
@@ -106,18 +129,23 @@ void GLFWBackend::iterate() {
 #endif
 
     m_timersMutex.lock();
-    auto ts = std::move(m_timersReady);
+    auto ts     = std::move(m_timersReady);
+    auto posted = std::move(m_posted);
     m_timersMutex.unlock();
 
     for (auto *t : ts) {
         t->onTimeout();
     }
+    for (auto &f : posted) {
+        f();
+    }
 
     if (!m_windowsToRender.empty()) {
         auto wins = std::move(m_windowsToRender);
         Renderer::instance().begin();
         for (auto *w : wins) {
             auto gw = static_cast<GLFWWindow *>(&w->backendWindow());
+            ImGuiAllocator::beginFrame(&gw->m_allocatorStats);
             ImGui::SetCurrentContext(gw->m_imgui);
             ImPlot::SetCurrentContext(gw->m_implot);
             if (w->surface().newFrame()) {
@@ -127,9 +155,12 @@ void GLFWBackend::iterate() {
                 w->render();
 
                 ImGui::Render();
+                w->frameRendered();
                 w->surface().present();
+                Startup::framePresented();
             }
         }
+        ImGuiAllocator::setCurrentStats(nullptr);
         Renderer::instance().end();
     }
 }
@@ -150,6 +181,7 @@ void GLFWBackend::run() {
 }
 
 GLFWWindow::~GLFWWindow() {
+    ImGuiAllocator::releaseStats(&m_allocatorStats);
     glfwDestroyWindow(m_win);
 }
 
@@ -176,4 +208,8 @@ Size GLFWWindow::pixelSize() const {
     return { w, h };
 }
 
+const AllocatorStats &GLFWWindow::allocatorStats() const {
+    return m_allocatorStats;
+}
+
 } // namespace ImChart::Backend
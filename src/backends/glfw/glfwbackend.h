@@ -27,11 +27,15 @@ public:
 
     void                    startTimer(Timer *t) final;
 
+    bool                    post(std::function<void()> f) final;
+    void                    postDelayed(std::function<void()> f, std::chrono::milliseconds delay) final;
+
 private:
-    void                           iterate();
-    std::vector<ImChart::Window *> m_windowsToRender;
-    std::mutex                     m_timersMutex;
-    std::vector<Timer *>           m_timersReady;
+    void                               iterate();
+    std::vector<ImChart::Window *>     m_windowsToRender;
+    std::mutex                         m_timersMutex; // also guards m_posted
+    std::vector<Timer *>               m_timersReady;
+    std::vector<std::function<void()>> m_posted;
 };
 
 class GLFWWindow : public Window {
@@ -43,11 +47,14 @@ public:
     void          setSize(int width, int height) override;
     void          show() override;
 
-    Size          pixelSize() const override;
+    Size                  pixelSize() const override;
+
+    const AllocatorStats &allocatorStats() const override;
 
-    GLFWwindow   *m_win;
-    ImGuiContext *m_imgui;
-    ImPlotContext *m_implot;
+    GLFWwindow           *m_win;
+    ImGuiContext         *m_imgui;
+    ImPlotContext        *m_implot;
+    AllocatorStats        m_allocatorStats;
 };
 
 }
@@ -0,0 +1,160 @@
+#include "imguiallocator.h"
+
+#include <algorithm>
+#include <iterator>
+#include <bit>
+#include <cstdlib>
+
+#include <imgui.h>
+
+namespace ImChart::Backend::ImGuiAllocator {
+
+namespace {
+
+// The header keeps the user pointer 16 byte aligned, as malloc would.
+struct alignas(16) BlockHeader {
+    uint32_t sizeClass;
+    uint32_t owner; // slot of the stats the block is accounted to
+    uint64_t size;
+};
+
+struct FreeBlock {
+    FreeBlock *next;
+};
+
+constexpr int      MIN_CLASS   = 4;  // 16 bytes
+constexpr int      MAX_CLASS   = 26; // 64 MB, bigger blocks go straight to malloc
+constexpr uint32_t LARGE_CLASS = ~0u;
+// Stats which blocks can be accounted to, slot 0 is the global stats
+constexpr int      MAX_OWNERS  = 64;
+
+FreeBlock         *g_freeLists[MAX_CLASS + 1] = {};
+size_t             g_pooledBytes              = 0;
+AllocatorStats     g_globalStats;
+AllocatorStats    *g_owners[MAX_OWNERS] = { &g_globalStats };
+uint32_t           g_current            = 0;
+bool               g_installed          = false;
+
+// The slot of 'stats', registering it if needed. Without a free slot, blocks only count globally.
+uint32_t ownerSlot(AllocatorStats *stats) {
+    const auto end  = std::end(g_owners);
+    auto       slot = std::find(std::begin(g_owners), end, stats);
+    if (slot == end) {
+        slot = std::find(std::begin(g_owners) + 1, end, nullptr);
+        if (slot == end) {
+            return 0;
+        }
+        *slot = stats;
+    }
+    return uint32_t(slot - std::begin(g_owners));
+}
+
+int                sizeClassFor(size_t size) {
+    const auto bytes = std::max(size + sizeof(BlockHeader), size_t(1) << MIN_CLASS);
+    return std::bit_width(bytes - 1);
+}
+
+void account(AllocatorStats *stats, int64_t bytes) {
+    stats->liveBytes += bytes;
+    if (bytes > 0) {
+        ++stats->frameAllocations;
+        stats->frameBytes += bytes;
+        stats->peakBytes = std::max(stats->peakBytes, stats->liveBytes);
+    }
+}
+
+void *allocate(size_t size, void *) {
+    const int cls = sizeClassFor(size);
+
+    void     *mem = nullptr;
+    if (cls > MAX_CLASS) {
+        mem = std::malloc(size + sizeof(BlockHeader));
+    } else if (auto block = g_freeLists[cls]) {
+        g_freeLists[cls] = block->next;
+        g_pooledBytes -= size_t(1) << cls;
+        mem = block;
+    } else {
+        mem = std::malloc(size_t(1) << cls);
+    }
+    if (!mem) {
+        return nullptr;
+    }
+
+    auto header       = static_cast<BlockHeader *>(mem);
+    header->sizeClass = cls > MAX_CLASS ? LARGE_CLASS : cls;
+    header->owner     = g_current;
+    header->size      = size;
+
+    if (g_current != 0) {
+        account(g_owners[g_current], size);
+    }
+    account(&g_globalStats, size);
+    return header + 1;
+}
+
+void deallocate(void *ptr, void *) {
+    if (!ptr) {
+        return;
+    }
+
+    // charged to the stats the block was allocated under, whichever window frees it
+    auto header = static_cast<BlockHeader *>(ptr) - 1;
+    if (auto owner = g_owners[header->owner]; owner && owner != &g_globalStats) {
+        owner->liveBytes -= header->size;
+    }
+    g_globalStats.liveBytes -= header->size;
+
+    if (header->sizeClass == LARGE_CLASS) {
+        std::free(header);
+        return;
+    }
+
+    const auto cls   = header->sizeClass;
+    auto       block = reinterpret_cast<FreeBlock *>(header);
+    block->next      = g_freeLists[cls];
+    g_freeLists[cls] = block;
+    g_pooledBytes += size_t(1) << cls;
+}
+
+} // namespace
+
+void install() {
+    if (g_installed) {
+        return;
+    }
+    ImGui::SetAllocatorFunctions(allocate, deallocate, nullptr);
+    g_installed = true;
+}
+
+void setCurrentStats(AllocatorStats *stats) {
+    g_current = stats ? ownerSlot(stats) : 0;
+}
+
+void releaseStats(AllocatorStats *stats) {
+    if (stats == &g_globalStats) {
+        return;
+    }
+    std::replace(std::begin(g_owners), std::end(g_owners), stats, static_cast<AllocatorStats *>(nullptr));
+    if (g_owners[g_current] == nullptr) {
+        g_current = 0;
+    }
+}
+
+void beginFrame(AllocatorStats *stats) {
+    setCurrentStats(stats);
+    auto &current                = *g_owners[g_current];
+    current.lastFrameAllocations = current.frameAllocations;
+    current.lastFrameBytes       = current.frameBytes;
+    current.frameAllocations     = 0;
+    current.frameBytes           = 0;
+}
+
+const AllocatorStats &globalStats() {
+    return g_globalStats;
+}
+
+size_t pooledBytes() {
+    return g_pooledBytes;
+}
+
+} // namespace ImChart::Backend::ImGuiAllocator
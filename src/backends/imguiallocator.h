@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ImChart::Backend {
+
+struct AllocatorStats {
+    // counters of the frame currently being built, reset by ImGuiAllocator::beginFrame()
+    uint64_t frameAllocations     = 0;
+    uint64_t frameBytes           = 0;
+    // counters of the last completed frame
+    uint64_t lastFrameAllocations = 0;
+    uint64_t lastFrameBytes       = 0;
+
+    uint64_t liveBytes            = 0;
+    uint64_t peakBytes            = 0;
+};
+
+/**
+ * Pooled allocator used for all ImGui and ImPlot allocations.
+ *
+ * Freed blocks are kept in power-of-two size class free lists instead of being returned to
+ * malloc, so the ImVectors of draw lists and temporary buffers keep their high-water capacity
+ * from one frame to the next. Allocations are accounted to the stats object set as current,
+ * which the backends switch together with the ImGui context of the window being rendered. A block
+ * remembers the stats it was allocated under, so freeing it while another window is current
+ * credits the right one.
+ *
+ * Like ImGui itself, the allocator must only be used from the UI thread.
+ */
+namespace ImGuiAllocator {
+
+// Registers the allocator with ImGui. Must be called before the first ImGui::CreateContext().
+void                  install();
+
+void                  setCurrentStats(AllocatorStats *stats);
+// Stops accounting to 'stats' before it is destroyed, its remaining blocks only count globally
+void                  releaseStats(AllocatorStats *stats);
+void                  beginFrame(AllocatorStats *stats);
+
+const AllocatorStats &globalStats();
+size_t                pooledBytes();
+
+} // namespace ImGuiAllocator
+
+} // namespace ImChart::Backend
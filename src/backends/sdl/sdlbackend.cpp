@@ -1,6 +1,8 @@
 #include "sdlbackend.h"
 
+#include <algorithm>
 #include <thread>
+#include <utility>
 
 #include <SDL.h>
 
@@ -18,6 +20,7 @@
 #include <implot.h>
 
 #include "renderers/renderer.h"
+#include "startup.h"
 #include "timer.h"
 #include "window.h"
 
@@ -39,11 +42,15 @@ void *SDLBackend::nativeDisplay() {
 #ifndef EMSCRIPTEN
 #ifdef X11_ENABLED
 
-    auto          win = SDL_CreateWindow("", 0, 0, 1, 1, SDL_WINDOW_HIDDEN);
+    // SDL only hands out the display of a window. Instead of a throwaway window, create the hidden
+    // window the first createWindow() call will use anyway.
+    if (!m_spareWindow) {
+        m_spareWindow = SDL_CreateWindow("", 0, 0, 1, 1, SDL_WINDOW_HIDDEN);
+    }
 
     SDL_SysWMinfo wmInfo;
     SDL_VERSION(&wmInfo.version);
-    SDL_GetWindowWMInfo(win, &wmInfo);
+    SDL_GetWindowWMInfo(m_spareWindow, &wmInfo);
     return wmInfo.info.x11.display;
 
 #endif
@@ -52,7 +59,13 @@ void *SDLBackend::nativeDisplay() {
 }
 
 std::unique_ptr<Window> SDLBackend::createWindow(ImChart::Window *window, int width, int height) {
-    auto win = SDL_CreateWindow("", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, width, height, SDL_WINDOW_HIDDEN);
+    auto win = std::exchange(m_spareWindow, nullptr);
+    if (win) {
+        SDL_SetWindowSize(win, width, height);
+        SDL_SetWindowPosition(win, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED);
+    } else {
+        win = SDL_CreateWindow("", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, width, height, SDL_WINDOW_HIDDEN);
+    }
     if (!win) {
         return nullptr;
     }
@@ -61,7 +74,10 @@ std::unique_ptr<Window> SDLBackend::createWindow(ImChart::Window *window, int wi
     w->m_win = win;
     SDL_SetWindowData(win, "window", window);
 
-    w->m_imgui  = ImGui::CreateContext();
+    ImGuiAllocator::install();
+    ImGuiAllocator::setCurrentStats(&w->m_allocatorStats);
+
+    w->m_imgui  = ImGui::CreateContext(&sharedFontAtlas());
     w->m_implot = ImPlot::CreateContext();
     ImGui::SetCurrentContext(w->m_imgui);
     ImPlot::SetCurrentContext(w->m_implot);
@@ -70,17 +86,21 @@ std::unique_ptr<Window> SDLBackend::createWindow(ImChart::Window *window, int wi
     (void) io;
     // io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
     // io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
+    // Keep the transient buffers of idle windows around instead of freeing and regrowing them
+    io.ConfigMemoryCompactTimer = -1.0f;
 
     // Setup Dear ImGui style
     ImGui::StyleColorsDark();
     // ImGui::StyleColorsLight();
 
     ImGui_ImplSDL2_InitForSDLRenderer(win, nullptr);
+    ImGuiAllocator::setCurrentStats(nullptr);
 
     return w;
 }
 
 static constexpr int TIMER_EVENT = SDL_USEREVENT + 1;
+static constexpr int POST_EVENT  = SDL_USEREVENT + 2;
 
 void                 SDLBackend::scheduleRender(ImChart::Window *window) {
                     m_windowsToRender.push_back(window);
@@ -118,6 +138,49 @@ void SDLBackend::startTimer(Timer *timer) {
 #endif
 }
 
+bool SDLBackend::post(std::function<void()> f) {
+    auto      p = new std::function<void()>(std::move(f));
+    SDL_Event e;
+    e.type       = POST_EVENT;
+    e.user.data1 = p;
+    if (SDL_PushEvent(&e) != 1) {
+        fmt::print(stderr, "Unable to post to the UI thread: {}\n", SDL_GetError());
+        delete p;
+        return false;
+    }
+    return true;
+}
+
+#if EMSCRIPTEN
+static void postEvent(void *p)
+#else
+static unsigned int postEvent(unsigned int, void *p)
+#endif
+{
+    SDL_Event e;
+    e.type       = POST_EVENT;
+    e.user.data1 = p;
+    if (SDL_PushEvent(&e) != 1) {
+        fmt::print(stderr, "Unable to post to the UI thread: {}\n", SDL_GetError());
+        delete static_cast<std::function<void()> *>(p);
+    }
+#ifndef EMSCRIPTEN
+    return 0; // one-shot
+#endif
+}
+
+void SDLBackend::postDelayed(std::function<void()> f, std::chrono::milliseconds delay) {
+    auto p = new std::function<void()>(std::move(f));
+#if EMSCRIPTEN
+    emscripten_async_call(postEvent, p, int(delay.count()));
+#else
+    if (SDL_AddTimer(std::max<unsigned int>(1, delay.count()), postEvent, p) == 0) {
+        fmt::print(stderr, "Unable to add a timer: {}\n", SDL_GetError());
+        delete p;
+    }
+#endif
+}
+
 bool SDLBackend::iterate() {
     auto processEvent = [this](const SDL_Event &event) {
         if (event.type == SDL_QUIT) {
@@ -126,6 +189,11 @@ bool SDLBackend::iterate() {
             auto t = static_cast<Timer *>(event.user.data1);
             t->onTimeout();
             return true;
+        } else if (event.type == POST_EVENT) {
+            auto f = static_cast<std::function<void()> *>(event.user.data1);
+            (*f)();
+            delete f;
+            return true;
         }
 
         if (ImGui_ImplSDL2_ProcessEvent(&event)) {
@@ -172,6 +240,7 @@ bool SDLBackend::iterate() {
         Renderer::instance().begin();
         for (auto *w : wins) {
             auto gw = static_cast<SDLWindow *>(&w->backendWindow());
+            ImGuiAllocator::beginFrame(&gw->m_allocatorStats);
             ImGui::SetCurrentContext(gw->m_imgui);
             ImPlot::SetCurrentContext(gw->m_implot);
             if (w->surface().newFrame()) {
@@ -181,9 +250,12 @@ bool SDLBackend::iterate() {
                 w->render();
 
                 ImGui::Render();
+                w->frameRendered();
                 w->surface().present();
+                Startup::framePresented();
             }
         }
+        ImGuiAllocator::setCurrentStats(nullptr);
         Renderer::instance().end();
     }
     return true;
@@ -205,6 +277,7 @@ void SDLBackend::run() {
 }
 
 SDLWindow::~SDLWindow() {
+    ImGuiAllocator::releaseStats(&m_allocatorStats);
     SDL_DestroyWindow(m_win);
 }
 
@@ -236,4 +309,8 @@ Size SDLWindow::pixelSize() const {
     return { w, h };
 }
 
+const AllocatorStats &SDLWindow::allocatorStats() const {
+    return m_allocatorStats;
+}
+
 } // namespace ImChart::Backend
@@ -27,9 +27,14 @@ public:
 
     void                    startTimer(Timer *t) final;
 
+    bool                    post(std::function<void()> f) final;
+    void                    postDelayed(std::function<void()> f, std::chrono::milliseconds delay) final;
+
 private:
     bool                           iterate();
     std::vector<ImChart::Window *> m_windowsToRender;
+    // created to query the native display before any window exists, reused by createWindow()
+    SDL_Window                    *m_spareWindow = nullptr;
 };
 
 class SDLWindow : public Window {
@@ -41,11 +46,14 @@ public:
     void           setSize(int width, int height) override;
     void           show() override;
 
-    Size           pixelSize() const override;
+    Size                  pixelSize() const override;
+
+    const AllocatorStats &allocatorStats() const override;
 
-    SDL_Window    *m_win;
-    ImGuiContext  *m_imgui;
-    ImPlotContext *m_implot;
+    SDL_Window           *m_win;
+    ImGuiContext         *m_imgui;
+    ImPlotContext        *m_implot;
+    AllocatorStats        m_allocatorStats;
 };
 
 }
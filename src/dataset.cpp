@@ -1,8 +1,49 @@
 #include "dataset.h"
 
+#include <algorithm>
+
 namespace ImChart {
 
 DataSet::~DataSet() {
 }
 
+int DataSet::addDataChangedListener(std::function<void(int, int)> listener) {
+    const int id = m_nextListenerId++;
+    m_dataChangedListeners.emplace_back(id, std::move(listener));
+    return id;
+}
+
+void DataSet::removeDataChangedListener(int id) {
+    std::erase_if(m_dataChangedListeners, [id](const auto &l) { return l.first == id; });
+}
+
+static const DataSet::ErrorSegment *findErrorSegment(std::span<const DataSet::ErrorSegment> segments, int index) {
+    auto it = std::upper_bound(segments.begin(), segments.end(), index, [](int i, const DataSet::ErrorSegment &s) { return i < s.start; });
+    return it == segments.begin() ? nullptr : &*(it - 1);
+}
+
+float DataSet::getPositiveError(int dimIndex, int index) {
+    switch (getErrorType(dimIndex)) {
+    case ErrorType::None: return 0;
+    case ErrorType::PerPoint: return getPositiveErrors(dimIndex)[index];
+    case ErrorType::Uniform:
+    case ErrorType::Segmented:
+        const auto s = findErrorSegment(getErrorSegments(dimIndex), index);
+        return s ? s->positive : 0;
+    }
+    return 0;
+}
+
+float DataSet::getNegativeError(int dimIndex, int index) {
+    switch (getErrorType(dimIndex)) {
+    case ErrorType::None: return 0;
+    case ErrorType::PerPoint: return getNegativeErrors(dimIndex)[index];
+    case ErrorType::Uniform:
+    case ErrorType::Segmented:
+        const auto s = findErrorSegment(getErrorSegments(dimIndex), index);
+        return s ? s->negative : 0;
+    }
+    return 0;
+}
+
 } // namespace ImChart
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <cstddef>
 #include <functional>
+#include <shared_mutex>
 #include <span>
+#include <utility>
+#include <vector>
 
 namespace ImChart {
 
@@ -15,6 +19,27 @@ public:
         Z
     };
 
+    enum class ErrorType {
+        None,
+        Uniform,   // a single error for all points, as the only entry of getErrorSegments()
+        Segmented, // constant errors over index ranges, see getErrorSegments()
+        PerPoint   // one error per point, see getPositiveErrors()/getNegativeErrors()
+    };
+
+    // The errors of a segment apply from 'start' up to the start of the next segment.
+    struct ErrorSegment {
+        int   start;
+        float positive;
+        float negative;
+    };
+
+    // Range of the values of one dimension within a storage segment
+    struct SegmentSummary {
+        float min;
+        float max;
+        int   count;
+    };
+
     /**
      * Gets the x value of the data point with the index i
      *
@@ -103,9 +128,54 @@ public:
     //      */
     virtual std::span<float> getValues(int dimIndex) = 0;
 
-    bool                     hasErrors               = false;
-    virtual std::span<float> getPositiveErrors(int dimIndex) { return {}; }
-    virtual std::span<float> getNegativeErrors(int dimIndex) { return {}; }
+    /**
+     * Data sets which do not keep their values in contiguous arrays expose them as a sequence of
+     * segments, and may return an empty span from getValues(). The default is a single segment
+     * covering getValues().
+     *
+     * @param dimIndex the dimension index (ie. '0' equals 'X', '1' equals 'Y')
+     * @param segment segment index, in [0, getSegmentCount())
+     * @return the values of the segment
+     */
+    virtual int                   getSegmentCount() const { return 1; }
+    virtual std::span<float>      getSegment(int dimIndex, int segment) { return getValues(dimIndex); }
+    // Precomputed min/max of a segment, or nullptr if the data set does not maintain them
+    virtual const SegmentSummary *getSegmentSummary(int dimIndex, int segment) const { return nullptr; }
+
+    /**
+     * Guards the segment table of data sets which restructure it while they change, like
+     * SegmentedDataSet appending blocks: they hold it exclusively while appending or clearing.
+     * Readers on other threads than the UI thread hold it shared while they use a segment, the
+     * spans and summaries they got are only valid until they release it.
+     */
+    std::shared_mutex            &storageLock() const { return m_storageLock; }
+
+    /**
+     * @return false while the data set still initializes its values in the background. Its values
+     * must not be accessed until then, dataChanged() is emitted once it is ready.
+     */
+    virtual bool             isReady() const { return true; }
+
+    /**
+     * @return number of bytes allocated for the values and errors held by the data set
+     */
+    virtual size_t           memoryUsage() const { return 0; }
+
+    bool                                hasErrors = false;
+    virtual ErrorType                   getErrorType(int dimIndex) const { return hasErrors ? ErrorType::PerPoint : ErrorType::None; }
+    virtual std::span<float>            getPositiveErrors(int dimIndex) { return {}; }
+    virtual std::span<float>            getNegativeErrors(int dimIndex) { return {}; }
+    virtual std::span<const ErrorSegment> getErrorSegments(int dimIndex) const { return {}; }
+
+    /**
+     * Gets the error of the data point with the index i, regardless of how the errors are stored.
+     *
+     * @param dimIndex the dimension index (ie. '0' equals 'X', '1' equals 'Y')
+     * @param index data point index
+     * @return the positive (resp. negative) error, or 0 if the data set has no errors
+     */
+    float                               getPositiveError(int dimIndex, int index);
+    float                               getNegativeError(int dimIndex, int index);
     //
     //     /**
     //      * @return Read-Write Lock to guard the DataSet
@@ -157,10 +227,22 @@ public:
     // signals:
     std::function<void(int, int)> onDataChanged;
 
+    // Listeners notified in addition to onDataChanged, for consumers like derived data sets which
+    // must not take over the callback of the application
+    int                           addDataChangedListener(std::function<void(int, int)> listener);
+    void                          removeDataChangedListener(int id);
+
     void                          dataChanged(int startIndex, int count) {
                                  if (onDataChanged)
             onDataChanged(startIndex, count);
+        for (auto &l : m_dataChangedListeners)
+            l.second(startIndex, count);
     }
+
+private:
+    std::vector<std::pair<int, std::function<void(int, int)>>> m_dataChangedListeners;
+    int                                                        m_nextListenerId = 0;
+    mutable std::shared_mutex                                  m_storageLock;
 };
 
 } // namespace ImChart
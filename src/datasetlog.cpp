@@ -0,0 +1,286 @@
+#include "datasetlog.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fmt/format.h>
+
+#include "backends/backend.h"
+#include "floatcodec.h"
+
+namespace ImChart {
+
+namespace {
+
+constexpr size_t FILE_BUFFER_SIZE = 1 << 20;
+
+constexpr size_t padding(size_t bytes) {
+    return (8 - bytes % 8) % 8;
+}
+
+// XORs the bit patterns of 'changes' into 'values'
+void applyChanges(const float *changes, float *values, int count) {
+    for (int i = 0; i < count; ++i) {
+        values[i] = std::bit_cast<float>(std::bit_cast<uint32_t>(values[i]) ^ std::bit_cast<uint32_t>(changes[i]));
+    }
+}
+
+// The time budget of a tick when replaying as fast as possible, so the UI thread keeps rendering
+constexpr auto MAX_SPEED_BUDGET = std::chrono::milliseconds(8);
+
+} // namespace
+
+DataSetRecorder::DataSetRecorder(DataSet &dataSet, std::FILE *file)
+    : m_dataSet(dataSet)
+    , m_file(file)
+    , m_start(std::chrono::steady_clock::now())
+    , m_recorded(dataSet.getDimension()) {
+    m_listenerId = m_dataSet.addDataChangedListener([this](int start, int count) { record(start, count); });
+}
+
+DataSetRecorder::~DataSetRecorder() {
+    m_dataSet.removeDataChangedListener(m_listenerId);
+    if (m_file) {
+        std::fclose(m_file);
+    }
+}
+
+std::unique_ptr<DataSetRecorder> DataSetRecorder::create(DataSet &dataSet, const std::string &path) {
+    auto file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        fmt::print(stderr, "Unable to create the data set log '{}': {}\n", path, strerror(errno));
+        return nullptr;
+    }
+    std::setvbuf(file, nullptr, _IOFBF, FILE_BUFFER_SIZE);
+
+    const DataSetLogHeader header = { DataSetLogHeader::MAGIC, DataSetLogHeader::VERSION, uint32_t(dataSet.getDimension()), 0 };
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        fmt::print(stderr, "Unable to write the data set log '{}': {}\n", path, strerror(errno));
+        std::fclose(file);
+        return nullptr;
+    }
+    return std::unique_ptr<DataSetRecorder>(new DataSetRecorder(dataSet, file));
+}
+
+void DataSetRecorder::record(int start, int count) {
+    if (!m_file) {
+        return;
+    }
+    const int dataCount = m_dataSet.getDataCount();
+    start               = std::clamp(start, 0, dataCount);
+    count               = std::clamp(count, 0, dataCount - start);
+
+    m_payload.clear();
+    const int dims = int(m_recorded.size());
+    for (int d = 0; d < dims; ++d) {
+        auto &recorded = m_recorded[d];
+        if (recorded.size() < size_t(dataCount)) {
+            recorded.resize(std::max(size_t(dataCount), recorded.size() * 2));
+        }
+        const auto values = m_dataSet.getValues(d);
+        if (values.size() < size_t(start + count)) {
+            // data sets without contiguous values
+            m_scratch.resize(count);
+            for (int i = 0; i < count; ++i) {
+                m_scratch[i] = m_dataSet.get(d, start + i);
+            }
+        }
+        const float *source = values.size() < size_t(start + count) ? m_scratch.data() : values.data() + start;
+        // XOR the new values into the recorded ones to get the changes, then record the new values
+        float *changes = recorded.data() + start;
+        applyChanges(source, changes, count);
+        FloatCodec::encode({ changes, size_t(count) }, m_encoded);
+        std::copy_n(source, count, changes);
+        m_payload.push_back(uint32_t(m_encoded.size()));
+        m_payload.insert(m_payload.end(), m_encoded.begin(), m_encoded.end());
+    }
+
+    const auto             time     = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start);
+    const size_t           payload  = m_payload.size() * sizeof(uint32_t);
+    const DataSetLogRecord record   = { uint64_t(time.count()), start, count, dataCount, uint32_t(payload) };
+    const uint8_t          zeros[8] = {};
+    if (std::fwrite(&record, sizeof(record), 1, m_file) != 1 || std::fwrite(m_payload.data(), 1, payload, m_file) != payload
+            || std::fwrite(zeros, 1, padding(payload), m_file) != padding(payload)) {
+        fail();
+        return;
+    }
+
+    ++m_records;
+    m_bytes += sizeof(record) + payload + padding(payload);
+}
+
+void DataSetRecorder::fail() {
+    fmt::print(stderr, "Unable to write the data set log, recording stopped: {}\n", strerror(errno));
+    // the listener stays registered until destruction, dataChanged() may be iterating the listeners
+    std::fclose(m_file);
+    m_file = nullptr;
+    m_recorded.clear();
+    m_recorded.shrink_to_fit();
+}
+
+DataSetLog::~DataSetLog() {
+    if (m_header) {
+        munmap(const_cast<DataSetLogHeader *>(m_header), m_size);
+    }
+}
+
+std::unique_ptr<DataSetLog> DataSetLog::open(const std::string &path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        fmt::print(stderr, "Unable to open the data set log '{}': {}\n", path, strerror(errno));
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(DataSetLogHeader)) {
+        fmt::print(stderr, "'{}' is not a data set log.\n", path);
+        close(fd);
+        return nullptr;
+    }
+    auto mem = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        fmt::print(stderr, "Unable to map the data set log '{}': {}\n", path, strerror(errno));
+        return nullptr;
+    }
+    // replay reads the records front to back
+    madvise(mem, st.st_size, MADV_SEQUENTIAL);
+
+    auto log      = std::unique_ptr<DataSetLog>(new DataSetLog);
+    log->m_header = static_cast<const DataSetLogHeader *>(mem);
+    log->m_size   = st.st_size;
+    if (log->m_header->magic != DataSetLogHeader::MAGIC || log->m_header->version != DataSetLogHeader::VERSION) {
+        fmt::print(stderr, "'{}' is not a data set log of version {}.\n", path, DataSetLogHeader::VERSION);
+        return nullptr;
+    }
+    return log;
+}
+
+std::optional<DataSetLog::Record> DataSetLog::read(size_t &offset) const {
+    offset = std::max(offset, sizeof(DataSetLogHeader));
+    if (m_size - offset < sizeof(DataSetLogRecord)) {
+        return {};
+    }
+    const auto  *base   = reinterpret_cast<const char *>(m_header);
+    const auto  *record = reinterpret_cast<const DataSetLogRecord *>(base + offset);
+    const size_t bytes  = record->payloadBytes;
+    // a record cut off by a crash of the recording process ends the log
+    if (record->count < 0 || bytes % sizeof(uint32_t) != 0 || (m_size - offset - sizeof(DataSetLogRecord)) < bytes) {
+        return {};
+    }
+    offset += sizeof(DataSetLogRecord) + bytes + padding(bytes);
+    return Record{ std::chrono::nanoseconds(record->time), record->start, record->count, record->dataCount, dimension(),
+        { reinterpret_cast<const uint32_t *>(record + 1), bytes / sizeof(uint32_t) } };
+}
+
+void DataSetLog::Record::apply(int dimIndex, std::span<float> values) const {
+    // skip the changes of the dimensions before
+    size_t pos = 0;
+    for (int d = 0; d < dimIndex && pos < payload.size(); ++d) {
+        pos += 1 + payload[pos];
+    }
+    if (pos >= payload.size() || start < 0 || values.size() < size_t(start) + count) {
+        return;
+    }
+    const size_t                    words = std::min<size_t>(payload[pos], payload.size() - pos - 1);
+    thread_local std::vector<float> changes;
+    changes.resize(count);
+    if (!FloatCodec::decode(payload.subspan(pos + 1, words), changes)) {
+        // the undecoded changes are zero and leave the values as they are
+        fmt::print(stderr, "Corrupt changes of dimension {} in the data set log.\n", dimIndex);
+    }
+    applyChanges(changes.data(), values.data() + start, count);
+}
+
+DataSetReplayer::DataSetReplayer(const DataSetLog &log, std::function<void(const DataSetLog::Record &)> sink)
+    : m_log(log)
+    , m_sink(std::move(sink)) {
+}
+
+void DataSetReplayer::start(double speed) {
+    stop();
+    m_speed    = std::max(speed, 0.);
+    m_offset   = 0;
+    m_next     = m_log.read(m_offset);
+    m_start    = std::chrono::steady_clock::now();
+    m_finished = !m_next;
+    m_replayed = 0;
+    m_lag      = {};
+    m_alive    = std::make_shared<bool>(true);
+    tick();
+}
+
+void DataSetReplayer::stop() {
+    m_alive.reset();
+}
+
+void DataSetReplayer::tick() {
+    using namespace std::chrono;
+    const auto now    = steady_clock::now();
+    // position in the log the replay should have reached
+    const auto target = m_speed > 0 ? duration_cast<nanoseconds>((now - m_start) * m_speed) : nanoseconds::max();
+
+    while (m_next && m_next->time <= target) {
+        if (m_speed > 0) {
+            m_lag = target - m_next->time;
+        }
+        m_sink(*m_next);
+        ++m_replayed;
+        m_next = m_log.read(m_offset);
+        if (m_speed == 0 && steady_clock::now() - now > MAX_SPEED_BUDGET) {
+            break;
+        }
+    }
+    if (!m_next) {
+        m_finished = true;
+        m_alive.reset();
+        return;
+    }
+
+    auto next = [this, alive = std::weak_ptr<bool>(m_alive)]() {
+        if (alive.lock()) {
+            tick();
+        }
+    };
+    if (m_speed == 0) {
+        Backend::instance().post(std::move(next));
+    } else {
+        const auto due = m_start + duration_cast<steady_clock::duration>(m_next->time / m_speed);
+        Backend::instance().postDelayed(std::move(next), std::max(milliseconds(0), duration_cast<milliseconds>(due - steady_clock::now())));
+    }
+}
+
+ReplayDataSet::ReplayDataSet(int dimension)
+    : m_values(dimension) {
+}
+
+size_t ReplayDataSet::memoryUsage() const {
+    size_t bytes = 0;
+    for (const auto &v : m_values) {
+        bytes += ImChart::memoryUsage(v);
+    }
+    return bytes;
+}
+
+void ReplayDataSet::apply(const DataSetLog::Record &record) {
+    m_dataCount    = std::max(record.dataCount, 0);
+    const int dims = std::min(getDimension(), record.dimension);
+    for (auto &v : m_values) {
+        if (v.size() < size_t(m_dataCount)) {
+            v.resize(std::max(size_t(m_dataCount), v.size() * 2));
+        }
+    }
+    const int start = std::clamp(record.start, 0, m_dataCount);
+    const int count = std::clamp(record.count, 0, m_dataCount - start);
+    for (int d = 0; d < dims; ++d) {
+        record.apply(d, { m_values[d].data(), m_values[d].size() });
+    }
+    dataChanged(start, count);
+}
+
+} // namespace ImChart
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "storage.h"
+#include <dataset.h>
+
+namespace ImChart {
+
+/**
+ * Binary log of the updates of a DataSet, to replay production traffic offline.
+ *
+ * The file starts with a DataSetLogHeader, followed by one DataSetLogRecord per dataChanged().
+ * Each record is followed by 'payloadBytes' of changes, padded to 8 bytes so the next record is
+ * aligned again. For each dimension the changes are a word count followed by that many words of
+ * FloatCodec packed values, XORed with the values the previous records left in the same range, so
+ * data sets re-emitting unchanged values cost about one word per 256 values.
+ */
+struct DataSetLogHeader {
+    static constexpr uint32_t MAGIC   = 0x4c444d49; // "IMDL"
+    static constexpr uint32_t VERSION = 2;
+
+    uint32_t                  magic;
+    uint32_t                  version;
+    uint32_t                  dimension;
+    uint32_t                  reserved;
+};
+
+struct DataSetLogRecord {
+    uint64_t time;      // nanoseconds since the start of the recording
+    int32_t  start;
+    int32_t  count;
+    int32_t  dataCount; // size of the data set after the change
+    uint32_t payloadBytes;
+};
+
+/**
+ * Appends every dataChanged() of a data set to a log file, until destroyed. Writing happens on the
+ * thread emitting the signal, through a large stdio buffer. Encoding the changes keeps a copy of
+ * the recorded values. A failed write is reported and stops the recording, see failed().
+ */
+class DataSetRecorder {
+public:
+    ~DataSetRecorder();
+
+    static std::unique_ptr<DataSetRecorder> create(DataSet &dataSet, const std::string &path);
+
+    uint64_t                                records() const { return m_records; }
+    uint64_t                                bytes() const { return m_bytes; }
+    bool                                    failed() const { return m_file == nullptr; }
+
+private:
+    DataSetRecorder(DataSet &dataSet, std::FILE *file);
+    void                                  record(int start, int count);
+    void                                  fail();
+
+    DataSet                              &m_dataSet;
+    std::FILE                            *m_file;
+    int                                   m_listenerId;
+    std::chrono::steady_clock::time_point m_start;
+    std::vector<float>                    m_scratch;
+    // the values as replaying the records so far reproduces them, zero where nothing was recorded
+    std::vector<FloatStorage>             m_recorded;
+    std::vector<uint32_t>                 m_encoded;
+    std::vector<uint32_t>                 m_payload;
+    uint64_t                              m_records = 0;
+    uint64_t                              m_bytes   = 0;
+};
+
+/**
+ * A log file mapped read-only. The payload of the records points directly into the mapping, reading
+ * them only touches the pages of the records replayed so far.
+ */
+class DataSetLog {
+public:
+    struct Record {
+        std::chrono::nanoseconds  time;
+        int                       start;
+        int                       count;
+        int                       dataCount;
+        int                       dimension;
+        std::span<const uint32_t> payload;
+
+        // Applies the changes of a dimension to 'values', the values of the dimension replayed so
+        // far, zero where no record wrote yet. 'values' must hold at least 'start + count' values.
+        void                      apply(int dimIndex, std::span<float> values) const;
+    };
+
+    ~DataSetLog();
+
+    static std::unique_ptr<DataSetLog> open(const std::string &path);
+
+    int                                dimension() const { return int(m_header->dimension); }
+    size_t                             size() const { return m_size; }
+
+    // Reads the record at 'offset' and advances 'offset' to the next one. 0 is the first record.
+    std::optional<Record>              read(size_t &offset) const;
+
+private:
+    DataSetLog() = default;
+
+    const DataSetLogHeader *m_header = nullptr;
+    size_t                  m_size   = 0;
+};
+
+/**
+ * Plays the records of a log back with their original timing, scaled by 'speed', or as fast as
+ * possible with a speed of 0. The records are passed to 'sink' on the UI thread, from the event
+ * loop, so the render loop sees the updates like it would in production.
+ */
+class DataSetReplayer {
+public:
+    DataSetReplayer(const DataSetLog &log, std::function<void(const DataSetLog::Record &)> sink);
+
+    void                     start(double speed = 1);
+    void                     stop();
+    bool                     isFinished() const { return m_finished; }
+
+    uint64_t                 replayed() const { return m_replayed; }
+    // How far the replay is behind the scheduled time of the records
+    std::chrono::nanoseconds lag() const { return m_lag; }
+
+private:
+    void                                             tick();
+
+    const DataSetLog                                &m_log;
+    std::function<void(const DataSetLog::Record &)> m_sink;
+    double                                           m_speed    = 1;
+    size_t                                           m_offset   = 0;
+    std::optional<DataSetLog::Record>                m_next;
+    std::chrono::steady_clock::time_point            m_start;
+    bool                                             m_finished = false;
+    uint64_t                                         m_replayed = 0;
+    std::chrono::nanoseconds                         m_lag      = {};
+    // Guards the ticks posted to the UI thread against stop() and the destruction of the replayer
+    std::shared_ptr<bool>                            m_alive;
+};
+
+/**
+ * Data set receiving the records of a replay, e.g. as DataSetReplayer sink:
+ *     DataSetReplayer replayer(*log, [&](const auto &record) { dataSet.apply(record); });
+ */
+class ReplayDataSet : public DataSet {
+public:
+    explicit ReplayDataSet(int dimension);
+
+    float            get(int dimIndex, int index) const final { return m_values[dimIndex][index]; }
+    int              getDataCount() const final { return m_dataCount; }
+    int              getDimension() const final { return int(m_values.size()); }
+    std::span<float> getValues(int dimIndex) final { return { m_values[dimIndex].data(), size_t(m_dataCount) }; }
+
+    size_t           memoryUsage() const final;
+
+    // Applies the changes of the record and emits dataChanged() for its range
+    void             apply(const DataSetLog::Record &record);
+
+private:
+    std::vector<FloatStorage> m_values;
+    int                       m_dataCount = 0;
+};
+
+} // namespace ImChart
@@ -0,0 +1,311 @@
+#include "deriveddataset.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <numbers>
+
+#include <fmt/format.h>
+
+#include "backends/backend.h"
+
+namespace ImChart {
+
+DerivedDataSet::DerivedDataSet(std::vector<DataSet *> inputs)
+    : m_inputs(std::move(inputs))
+    , m_snapshots(m_inputs.size()) {
+    for (size_t i = 0; i < m_inputs.size(); ++i) {
+        m_listenerIds.push_back(m_inputs[i]->addDataChangedListener([this, i](int start, int count) { inputChanged(i, start, count); }));
+    }
+}
+
+DerivedDataSet::~DerivedDataSet() {
+    if (m_pending.valid() && m_pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        // the computation calls compute() of a subclass which is already destroyed
+        fmt::print(stderr, "DerivedDataSet destroyed while computing, its subclass must call waitForComputation() in its destructor.\n");
+        std::terminate();
+    }
+    for (size_t i = 0; i < m_inputs.size(); ++i) {
+        m_inputs[i]->removeDataChangedListener(m_listenerIds[i]);
+    }
+}
+
+void DerivedDataSet::waitForComputation() const {
+    if (m_pending.valid()) {
+        m_pending.wait();
+    }
+}
+
+float DerivedDataSet::get(int dimIndex, int index) const {
+    update();
+    return (dimIndex == 0 ? _xdata : _ydata)[index];
+}
+
+std::span<float> DerivedDataSet::getValues(int dimIndex) {
+    update();
+    return dimIndex == 0 ? _xdata : _ydata;
+}
+
+size_t DerivedDataSet::memoryUsage() const {
+    size_t bytes = ImChart::memoryUsage(_xdata) + ImChart::memoryUsage(_ydata);
+    for (const auto &snapshot : m_snapshots) {
+        bytes += ImChart::memoryUsage(snapshot.values[0]) + ImChart::memoryUsage(snapshot.values[1]);
+    }
+    return bytes;
+}
+
+void DerivedDataSet::inputChanged(size_t input, int start, int count) {
+    auto &snapshot      = m_snapshots[input];
+    snapshot.dirtyStart = std::min(snapshot.dirtyStart, std::max(0, start));
+    snapshot.dirtyEnd   = std::max(snapshot.dirtyEnd, start + std::max(0, count));
+
+    const auto range = affectedRange(start, count);
+    const int  s     = std::max(0, range.first);
+    const int  e     = std::min(range.second, outputSize());
+    m_dirtyStart     = std::min(m_dirtyStart, s);
+    m_dirtyEnd       = std::max(m_dirtyEnd, e);
+    if (m_async) {
+        launch();
+    }
+    dataChanged(s, std::max(0, e - s));
+}
+
+std::pair<int, int> DerivedDataSet::takeDirtyRange() const {
+    const int size  = outputSize();
+    auto      range = std::pair(std::max(0, m_dirtyStart), std::min(m_dirtyEnd, size));
+    if (int(_ydata.size()) != size) {
+        _xdata.resize(size);
+        _ydata.resize(size);
+        range = { 0, size };
+    }
+    m_dirtyStart = std::numeric_limits<int>::max();
+    m_dirtyEnd   = 0;
+    return range;
+}
+
+void DerivedDataSet::launch() {
+    // if a computation is running, the range changed in the meantime is computed by the next update()
+    if (m_pending.valid()) {
+        if (m_pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
+        }
+        // a result nobody read yet, its values are in place
+        m_pending.get();
+    }
+    const auto [start, end] = takeDirtyRange();
+    if (start < end) {
+        m_pending = Backend::threadPool().async("derived data set", [this, start, end, inputs = takeSnapshot()]() {
+            compute(start, end, inputs, _xdata.data(), _ydata.data());
+        });
+    }
+}
+
+DerivedDataSet::InputValues DerivedDataSet::inputValues() const {
+    InputValues values;
+    for (auto *input : m_inputs) {
+        values.push_back(input->getValues(0));
+        values.push_back(input->getValues(1));
+    }
+    return values;
+}
+
+DerivedDataSet::InputValues DerivedDataSet::takeSnapshot() {
+    // no computation is running, nothing reads the snapshots
+    for (size_t i = 0; i < m_inputs.size(); ++i) {
+        auto &snapshot = m_snapshots[i];
+        for (int d = 0; d < 2; ++d) {
+            const auto values = m_inputs[i]->getValues(d);
+            auto      &copy   = snapshot.values[d];
+            if (copy.size() != values.size()) {
+                copy.assign(values.begin(), values.end());
+                continue;
+            }
+            const size_t start = std::min(size_t(snapshot.dirtyStart), values.size());
+            const size_t end   = std::min(size_t(std::max(snapshot.dirtyEnd, 0)), values.size());
+            if (start < end) {
+                std::copy(values.begin() + start, values.begin() + end, copy.begin() + start);
+            }
+        }
+        snapshot.dirtyStart = std::numeric_limits<int>::max();
+        snapshot.dirtyEnd   = 0;
+    }
+
+    InputValues values;
+    for (const auto &snapshot : m_snapshots) {
+        values.push_back(snapshot.values[0]);
+        values.push_back(snapshot.values[1]);
+    }
+    return values;
+}
+
+void DerivedDataSet::update() const {
+    if (m_pending.valid()) {
+        // the values of a derived input may be read from the computation of this one
+        Backend::threadPool().get(m_pending);
+    }
+    const auto [start, end] = takeDirtyRange();
+    if (start < end) {
+        compute(start, end, inputValues(), _xdata.data(), _ydata.data());
+    }
+}
+
+ScaleDataSet::ScaleDataSet(DataSet *input, float factor, float offset)
+    : DerivedDataSet({ input })
+    , m_factor(factor)
+    , m_offset(offset) {
+}
+
+ScaleDataSet::~ScaleDataSet() {
+    waitForComputation();
+}
+
+int ScaleDataSet::outputSize() const {
+    return m_inputs[0]->getDataCount();
+}
+
+void ScaleDataSet::compute(int start, int end, const InputValues &inputs, float *x, float *y) const {
+    const auto xs = inputs[0];
+    const auto ys = inputs[1];
+    std::copy(xs.begin() + start, xs.begin() + end, x + start);
+
+    const float *__restrict in  = ys.data();
+    float *__restrict       out = y;
+    const float             a   = m_factor;
+    const float             b   = m_offset;
+    for (int i = start; i < end; ++i) {
+        out[i] = a * in[i] + b;
+    }
+}
+
+AddDataSet::AddDataSet(DataSet *a, DataSet *b, float factor)
+    : DerivedDataSet({ a, b })
+    , m_factor(factor) {
+}
+
+AddDataSet::~AddDataSet() {
+    waitForComputation();
+}
+
+int AddDataSet::outputSize() const {
+    return std::min(m_inputs[0]->getDataCount(), m_inputs[1]->getDataCount());
+}
+
+void AddDataSet::compute(int start, int end, const InputValues &inputs, float *x, float *y) const {
+    const auto xs = inputs[0];
+    const auto as = inputs[1];
+    const auto bs = inputs[3];
+    std::copy(xs.begin() + start, xs.begin() + end, x + start);
+
+    const float *__restrict a   = as.data();
+    const float *__restrict b   = bs.data();
+    float *__restrict       out = y;
+    const float             f   = m_factor;
+    for (int i = start; i < end; ++i) {
+        out[i] = a[i] + f * b[i];
+    }
+}
+
+MovingAverageDataSet::MovingAverageDataSet(DataSet *input, int window)
+    : DerivedDataSet({ input })
+    , m_halfWindow(std::max(0, window / 2)) {
+}
+
+MovingAverageDataSet::~MovingAverageDataSet() {
+    waitForComputation();
+}
+
+int MovingAverageDataSet::outputSize() const {
+    return m_inputs[0]->getDataCount();
+}
+
+std::pair<int, int> MovingAverageDataSet::affectedRange(int start, int count) const {
+    return { start - m_halfWindow, start + count + m_halfWindow };
+}
+
+void MovingAverageDataSet::compute(int start, int end, const InputValues &inputs, float *x, float *y) const {
+    const auto xs = inputs[0];
+    const auto ys = inputs[1];
+    const int  n  = int(ys.size());
+    std::copy(xs.begin() + start, xs.begin() + end, x + start);
+
+    // running sum over the window [i - h, i + h], clipped to the data
+    const int h   = m_halfWindow;
+    double    sum = 0;
+    for (int j = std::max(0, start - h); j <= std::min(n - 1, start + h); ++j) {
+        sum += ys[j];
+    }
+    for (int i = start; i < end; ++i) {
+        const int first = std::max(0, i - h);
+        const int last  = std::min(n - 1, i + h);
+        y[i]            = float(sum / (last - first + 1));
+        if (i - h >= 0) {
+            sum -= ys[i - h];
+        }
+        if (i + h + 1 < n) {
+            sum += ys[i + h + 1];
+        }
+    }
+}
+
+SpectrumDataSet::SpectrumDataSet(DataSet *input)
+    : DerivedDataSet({ input }) {
+}
+
+SpectrumDataSet::~SpectrumDataSet() {
+    waitForComputation();
+}
+
+int SpectrumDataSet::outputSize() const {
+    const auto n = std::bit_floor(unsigned(m_inputs[0]->getDataCount()));
+    return n < 2 ? 0 : int(n / 2 + 1);
+}
+
+void SpectrumDataSet::compute(int, int, const InputValues &inputs, float *x, float *y) const {
+    const auto                       xs = inputs[0];
+    const auto                       ys = inputs[1];
+    const int                        n  = int(std::bit_floor(unsigned(ys.size())));
+
+    std::vector<std::complex<float>> data(n);
+    float                            windowSum = 0;
+    for (int i = 0; i < n; ++i) {
+        const float w = 0.5f - 0.5f * std::cos(2 * std::numbers::pi_v<float> * i / (n - 1));
+        data[i]       = ys[i] * w;
+        windowSum += w;
+    }
+
+    // iterative radix-2 FFT
+    for (int i = 1, j = 0; i < n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        const auto step = std::polar(1.f, -2 * std::numbers::pi_v<float> / len);
+        for (int i = 0; i < n; i += len) {
+            std::complex<float> w(1);
+            for (int k = 0; k < len / 2; ++k) {
+                const auto u          = data[i + k];
+                const auto v          = data[i + k + len / 2] * w;
+                data[i + k]           = u + v;
+                data[i + k + len / 2] = u - v;
+                w *= step;
+            }
+        }
+    }
+
+    const float dx    = (xs[n - 1] - xs[0]) / (n - 1);
+    const float df    = dx > 0 ? 1 / (dx * n) : 1;
+    const float scale = 2 / windowSum;
+    for (int k = 0; k <= n / 2; ++k) {
+        x[k] = k * df;
+        y[k] = std::abs(data[k]) * scale;
+    }
+}
+
+} // namespace ImChart
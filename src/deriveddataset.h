@@ -0,0 +1,145 @@
+#pragma once
+
+#include <future>
+#include <limits>
+#include <vector>
+
+#include "storage.h"
+#include <dataset.h>
+
+namespace ImChart {
+
+/**
+ * Base class of data sets computed from other data sets.
+ *
+ * A derived data set listens to the dataChanged() signal of its inputs, but only records the
+ * output range affected by the change and forwards it to its own listeners. The values are
+ * recomputed when they are read, so changes that are never plotted cost nothing, and several
+ * changes between two frames are folded into a single recomputation.
+ *
+ * With setAsync(true), the recomputation is started on the thread pool as soon as an input
+ * changes, and reading the values waits for it to finish. It reads a snapshot of the inputs taken
+ * when it is started, which only copies the input ranges changed since the previous one, so the
+ * inputs may change again while it runs.
+ *
+ * The computation calls compute() of the subclass, so every subclass destructor must call
+ * waitForComputation(). Destroying a data set while it computes terminates the program.
+ */
+class DerivedDataSet : public DataSet {
+public:
+    ~DerivedDataSet();
+
+    float            get(int dimIndex, int index) const final;
+    int              getDataCount() const final { return outputSize(); }
+    int              getDimension() const final { return 2; }
+    std::span<float> getValues(int dimIndex) final;
+
+    size_t           memoryUsage() const final;
+
+    void             setAsync(bool async) { m_async = async; }
+    bool             isAsync() const { return m_async; }
+
+protected:
+    explicit DerivedDataSet(std::vector<DataSet *> inputs);
+
+    // Size of the output for the current size of the inputs
+    virtual int                 outputSize() const = 0;
+    // Output range [start, end) which depends on the input range [start, start + count)
+    virtual std::pair<int, int> affectedRange(int start, int count) const { return { 0, outputSize() }; }
+    // The x and y values of the inputs, input i at [2 * i] and [2 * i + 1]
+    using InputValues = std::vector<std::span<const float>>;
+    // Recomputes the output range [start, end) from the input values
+    virtual void                compute(int start, int end, const InputValues &inputs, float *x, float *y) const = 0;
+
+    // Waits for a running computation, subclasses must call it in their destructor
+    void                         waitForComputation() const;
+
+    const std::vector<DataSet *> m_inputs;
+
+private:
+    // Copy of the values of an input for asynchronous computations
+    struct Snapshot {
+        FloatStorage values[2];
+        int          dirtyStart = 0;
+        int          dirtyEnd   = std::numeric_limits<int>::max();
+    };
+
+    void                      inputChanged(size_t input, int start, int count);
+    void                      launch();
+    void                      update() const;
+    std::pair<int, int>       takeDirtyRange() const;
+    InputValues               inputValues() const;
+    InputValues               takeSnapshot();
+
+    std::vector<int>          m_listenerIds;
+    std::vector<Snapshot>     m_snapshots;
+    bool                      m_async      = false;
+    mutable int               m_dirtyStart = 0;
+    mutable int               m_dirtyEnd   = std::numeric_limits<int>::max();
+    mutable std::future<void> m_pending;
+    mutable FloatStorage      _xdata;
+    mutable FloatStorage      _ydata;
+};
+
+// y = factor * input.y + offset
+class ScaleDataSet : public DerivedDataSet {
+public:
+    ScaleDataSet(DataSet *input, float factor, float offset = 0);
+    ~ScaleDataSet();
+
+protected:
+    int                 outputSize() const final;
+    std::pair<int, int> affectedRange(int start, int count) const final { return { start, start + count }; }
+    void                compute(int start, int end, const InputValues &inputs, float *x, float *y) const final;
+
+private:
+    float m_factor;
+    float m_offset;
+};
+
+// y = a.y + factor * b.y, taking the x values of 'a'. A factor of -1 gives the difference of two channels.
+class AddDataSet : public DerivedDataSet {
+public:
+    AddDataSet(DataSet *a, DataSet *b, float factor = 1);
+    ~AddDataSet();
+
+protected:
+    int                 outputSize() const final;
+    std::pair<int, int> affectedRange(int start, int count) const final { return { start, start + count }; }
+    void                compute(int start, int end, const InputValues &inputs, float *x, float *y) const final;
+
+private:
+    float m_factor;
+};
+
+// Centered moving average of the y values over 'window' points
+class MovingAverageDataSet : public DerivedDataSet {
+public:
+    MovingAverageDataSet(DataSet *input, int window);
+    ~MovingAverageDataSet();
+
+protected:
+    int                 outputSize() const final;
+    std::pair<int, int> affectedRange(int start, int count) const final;
+    void                compute(int start, int end, const InputValues &inputs, float *x, float *y) const final;
+
+private:
+    int m_halfWindow;
+};
+
+/**
+ * Magnitude spectrum of the y values of the input, which must be sampled equidistantly. The
+ * transform uses the largest power of two of input points, Hann windowed. The x values are the
+ * frequencies in units of 1 / input x unit.
+ */
+class SpectrumDataSet : public DerivedDataSet {
+public:
+    explicit SpectrumDataSet(DataSet *input);
+    ~SpectrumDataSet();
+
+protected:
+    int  outputSize() const final;
+    void compute(int start, int end, const InputValues &inputs, float *x, float *y) const final;
+};
+
+} // namespace ImChart
@@ -0,0 +1,100 @@
+#include "digitaldataset.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace ImChart {
+
+DigitalDataSet::DigitalDataSet(int channels, int samples, float x0, float dt)
+    : m_channels(std::max(1, channels))
+    , m_samples(std::max(0, samples))
+    , m_wordsPerChannel((m_samples + 63) / 64)
+    , m_x0(x0)
+    , m_dt(dt)
+    , m_bits(size_t(m_channels) * m_wordsPerChannel)
+    , m_edges(m_channels) {
+}
+
+DigitalDataSet::~DigitalDataSet() {
+}
+
+float DigitalDataSet::get(int dimIndex, int index) const {
+    if (dimIndex == 0) {
+        return m_x0 + index * m_dt;
+    }
+    return bit(dimIndex - 1, index) ? 1.f : 0.f;
+}
+
+size_t DigitalDataSet::memoryUsage() const {
+    size_t edges = 0;
+    for (const auto &e : m_edges) {
+        edges += e.capacity() * sizeof(int);
+    }
+    return m_bits.capacity() * sizeof(uint64_t) + edges;
+}
+
+void DigitalDataSet::setBits(int channel, int start, std::span<const uint8_t> values) {
+    // the values before sample 0 or past the end are dropped
+    uint64_t *w     = words(channel);
+    const int skip  = std::clamp(-start, 0, int(values.size()));
+    const int count = std::min(int(values.size()), m_samples - start);
+    for (int i = skip; i < count; ++i) {
+        const int      index = start + i;
+        const uint64_t mask  = uint64_t(1) << (index % 64);
+        w[index / 64]        = values[i] ? w[index / 64] | mask : w[index / 64] & ~mask;
+    }
+}
+
+void DigitalDataSet::setWords(int channel, int startWord, std::span<const uint64_t> values) {
+    const int skip  = std::clamp(-startWord, 0, int(values.size()));
+    const int count = std::min(int(values.size()), m_wordsPerChannel - startWord);
+    if (skip < count) {
+        std::copy(values.begin() + skip, values.begin() + count, words(channel) + startWord + skip);
+    }
+}
+
+void DigitalDataSet::commit(int start, int count) {
+    const int end = std::clamp(start + count, 0, m_samples);
+    start         = std::clamp(start, 0, m_samples);
+    count         = end - start;
+    // an edge at i depends on the samples i - 1 and i, so the sample after the range is affected too
+    const int first = std::max(1, start);
+    const int last  = std::min(m_samples - 1, start + count);
+    for (int c = 0; c < m_channels; ++c) {
+        updateEdges(c, first, last);
+    }
+    dataChanged(start, count);
+}
+
+void DigitalDataSet::updateEdges(int channel, int first, int last) {
+    if (first > last) {
+        return;
+    }
+
+    // Bit j of w ^ (w << 1 | carry) is set where sample 64 * i + j differs from the one before
+    const uint64_t  *w = words(channel);
+    std::vector<int> found;
+    for (int i = first / 64; i <= last / 64; ++i) {
+        const uint64_t carry   = i > 0 ? w[i - 1] >> 63 : w[i] & 1;
+        uint64_t       changes = w[i] ^ (w[i] << 1 | carry);
+        if (i == first / 64) {
+            changes &= ~uint64_t(0) << (first % 64);
+        }
+        if (i == last / 64 && last % 64 != 63) {
+            changes &= (uint64_t(1) << (last % 64 + 1)) - 1;
+        }
+        while (changes) {
+            found.push_back(i * 64 + std::countr_zero(changes));
+            changes &= changes - 1;
+        }
+    }
+
+    auto      &edges = m_edges[channel];
+    const auto lo    = std::lower_bound(edges.begin(), edges.end(), first);
+    const auto hi    = std::upper_bound(lo, edges.end(), last);
+    const auto pos   = lo - edges.begin();
+    edges.erase(lo, hi);
+    edges.insert(edges.begin() + pos, found.begin(), found.end());
+}
+
+} // namespace ImChart
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <dataset.h>
+
+namespace ImChart {
+
+/**
+ * Many 1-bit signals sampled at a fixed rate, e.g. the trigger lines of a timing system.
+ *
+ * Every channel stores one bit per sample, packed into 64 bit words, and keeps the sorted sample
+ * indices of its transitions: edges(c) holds every index i where the bit differs from the bit at
+ * i - 1. The transitions are found by XOR-ing whole words with their shifted neighbours, so updating
+ * them costs a few operations per 64 samples, and a plot only needs the edges in its range.
+ *
+ * Dimension 0 is the sample time x0 + i * dt, dimension 1 + c the bit of channel c as 0 or 1. The
+ * values are not stored as floats, so getValues() returns empty spans; use get(), bit() or edges().
+ *
+ * Producers write with setBits()/setWords() and then call commit() for the range they wrote,
+ * which updates the edges and emits dataChanged().
+ */
+class DigitalDataSet : public DataSet {
+public:
+    DigitalDataSet(int channels, int samples, float x0 = 0, float dt = 1);
+    ~DigitalDataSet();
+
+    float                   get(int dimIndex, int index) const final;
+    int                     getDataCount() const final { return m_samples; }
+    int                     getDimension() const final { return 1 + m_channels; }
+    std::span<float>        getValues(int dimIndex) final { return {}; }
+
+    size_t                  memoryUsage() const final;
+
+    int                     channels() const { return m_channels; }
+    float                   x0() const { return m_x0; }
+    float                   dt() const { return m_dt; }
+
+    bool                    bit(int channel, int index) const { return (words(channel)[index / 64] >> (index % 64)) & 1; }
+    const std::vector<int> &edges(int channel) const { return m_edges[channel]; }
+
+    // Sets the bits [start, start + values.size()) of the channel, a non-zero byte is a 1
+    void                    setBits(int channel, int start, std::span<const uint8_t> values);
+    // Overwrites whole words, bit j of word w is sample 64 * w + j
+    void                    setWords(int channel, int startWord, std::span<const uint64_t> values);
+    // Updates the edges of all channels for the samples [start, start + count) and emits dataChanged()
+    void                    commit(int start, int count);
+
+private:
+    const uint64_t               *words(int channel) const { return m_bits.data() + size_t(channel) * m_wordsPerChannel; }
+    uint64_t                     *words(int channel) { return m_bits.data() + size_t(channel) * m_wordsPerChannel; }
+    // Recomputes the edges of the channel at the sample indices [first, last]
+    void                          updateEdges(int channel, int first, int last);
+
+    int                           m_channels;
+    int                           m_samples;
+    int                           m_wordsPerChannel;
+    float                         m_x0;
+    float                         m_dt;
+    std::vector<uint64_t>         m_bits;
+    std::vector<std::vector<int>> m_edges;
+};
+
+} // namespace ImChart
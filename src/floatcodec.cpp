@@ -0,0 +1,139 @@
+#include "floatcodec.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace ImChart::FloatCodec {
+
+namespace {
+
+constexpr int LANES    = 8;
+constexpr int FRAME    = 256;
+constexpr int PER_LANE = FRAME / LANES;
+
+// frame header: the bit width, and the flag for second order differences
+constexpr uint32_t SECOND_ORDER = 1 << 8;
+
+constexpr uint32_t zigzag(uint32_t d) {
+    return (d << 1) ^ uint32_t(int32_t(d) >> 31);
+}
+
+constexpr uint32_t unzigzag(uint32_t z) {
+    return (z >> 1) ^ (0u - (z & 1));
+}
+
+// Value p * LANES + l goes to lane l at bit p * width, word k of lane l is out[k * LANES + l]
+void pack(const uint32_t *residuals, int width, std::vector<uint32_t> &out) {
+    const size_t base = out.size();
+    out.resize(base + size_t(width) * LANES);
+    if (width == 0) {
+        return;
+    }
+    uint32_t *words = out.data() + base;
+    for (int p = 0; p < PER_LANE; ++p) {
+        const int offset = p * width;
+        const int word   = offset / 32;
+        const int shift  = offset % 32;
+        for (int l = 0; l < LANES; ++l) {
+            const uint32_t v = residuals[p * LANES + l];
+            words[word * LANES + l] |= v << shift;
+            if (shift + width > 32) {
+                words[(word + 1) * LANES + l] |= v >> (32 - shift);
+            }
+        }
+    }
+}
+
+void unpack(const uint32_t *words, int width, uint32_t *residuals) {
+    if (width == 0) {
+        std::fill_n(residuals, FRAME, 0u);
+        return;
+    }
+    const uint32_t mask = width == 32 ? ~0u : (1u << width) - 1;
+    for (int p = 0; p < PER_LANE; ++p) {
+        const int offset = p * width;
+        const int word   = offset / 32;
+        const int shift  = offset % 32;
+        // the same shift for all lanes, the lane loop compiles to vector shifts
+        if (shift + width > 32) {
+            for (int l = 0; l < LANES; ++l) {
+                residuals[p * LANES + l] = ((words[word * LANES + l] >> shift) | (words[(word + 1) * LANES + l] << (32 - shift))) & mask;
+            }
+        } else {
+            for (int l = 0; l < LANES; ++l) {
+                residuals[p * LANES + l] = (words[word * LANES + l] >> shift) & mask;
+            }
+        }
+    }
+}
+
+} // namespace
+
+void encode(std::span<const float> values, std::vector<uint32_t> &out) {
+    out.clear();
+    uint32_t first[FRAME];
+    uint32_t second[FRAME];
+    uint32_t previous      = 0;
+    uint32_t previousDelta = 0;
+    for (size_t f = 0; f < values.size(); f += FRAME) {
+        const int n         = int(std::min<size_t>(FRAME, values.size() - f));
+        uint32_t  anyFirst  = 0;
+        uint32_t  anySecond = 0;
+        for (int i = 0; i < n; ++i) {
+            const uint32_t bits  = std::bit_cast<uint32_t>(values[f + i]);
+            const uint32_t delta = bits - previous;
+            first[i]             = zigzag(delta);
+            second[i]            = zigzag(delta - previousDelta);
+            anyFirst |= first[i];
+            anySecond |= second[i];
+            previous      = bits;
+            previousDelta = delta;
+        }
+        std::fill(first + n, first + FRAME, 0u);
+        std::fill(second + n, second + FRAME, 0u);
+
+        const bool useSecond = std::bit_width(anySecond) < std::bit_width(anyFirst);
+        const int  width     = std::bit_width(useSecond ? anySecond : anyFirst);
+        out.push_back(uint32_t(width) | (useSecond ? SECOND_ORDER : 0));
+        pack(useSecond ? second : first, width, out);
+    }
+}
+
+bool decode(std::span<const uint32_t> packed, std::span<float> out) {
+    uint32_t residuals[FRAME];
+    uint32_t previous      = 0;
+    uint32_t previousDelta = 0;
+    size_t   pos           = 0;
+    size_t   f             = 0;
+    for (; f < out.size() && pos < packed.size(); f += FRAME) {
+        const uint32_t header = packed[pos++];
+        const int      width  = int(header & 0xff);
+        if (width > 32 || size_t(width) * LANES > packed.size() - pos) {
+            break;
+        }
+        unpack(packed.data() + pos, width, residuals);
+        pos += size_t(width) * LANES;
+
+        const int n = int(std::min<size_t>(FRAME, out.size() - f));
+        if (header & SECOND_ORDER) {
+            for (int i = 0; i < n; ++i) {
+                previousDelta += unzigzag(residuals[i]);
+                previous += previousDelta;
+                out[f + i] = std::bit_cast<float>(previous);
+            }
+        } else {
+            for (int i = 0; i < n; ++i) {
+                previousDelta = unzigzag(residuals[i]);
+                previous += previousDelta;
+                out[f + i] = std::bit_cast<float>(previous);
+            }
+        }
+    }
+    if (f < out.size()) {
+        std::fill(out.begin() + f, out.end(), 0.f);
+        return false;
+    }
+    return true;
+}
+
+} // namespace ImChart::FloatCodec
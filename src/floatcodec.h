@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+ * Lossless compression of float sample arrays.
+ *
+ * The bit patterns of consecutive values are turned into differences, of first order for signals
+ * or of second order for regularly spaced values like timestamps, whichever packs smaller for each
+ * frame of 256 values. The zigzag encoded differences are bit-packed at the width of the largest
+ * one, interleaved over 8 lanes, so unpacking shifts all lanes by the same amount and vectorizes.
+ */
+namespace ImChart::FloatCodec {
+
+void encode(std::span<const float> values, std::vector<uint32_t> &out);
+// Decodes the first 'out.size()' values of 'packed'. Returns false if 'packed' is too short or
+// corrupt, the values which could not be decoded are zero then.
+bool decode(std::span<const uint32_t> packed, std::span<float> out);
+
+} // namespace ImChart::FloatCodec
@@ -0,0 +1,298 @@
+#include "fontatlascache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <imgui.h>
+
+namespace ImChart::FontAtlasCache {
+
+namespace {
+
+constexpr uint32_t MAGIC = 0x43414649; // "IFAC"
+
+struct Hash {
+    uint64_t value = 0xcbf29ce484222325ull; // FNV-1a
+
+    void     add(const void *data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            value = (value ^ static_cast<const uint8_t *>(data)[i]) * 0x100000001b3ull;
+        }
+    }
+    template<typename T>
+    void add(const T &v) {
+        add(&v, sizeof(T));
+    }
+};
+
+// Everything the built atlas depends on
+uint64_t atlasKey(const ImFontAtlas &atlas) {
+    Hash h;
+    h.add(IMGUI_VERSION_NUM);
+    h.add(atlas.Flags);
+    h.add(atlas.TexDesiredWidth);
+    h.add(atlas.TexGlyphPadding);
+    for (const auto &cfg : atlas.ConfigData) {
+        h.add(cfg.FontData, cfg.FontDataSize);
+        h.add(cfg.FontNo);
+        h.add(cfg.SizePixels);
+        h.add(cfg.OversampleH);
+        h.add(cfg.OversampleV);
+        h.add(cfg.PixelSnapH);
+        h.add(cfg.GlyphExtraSpacing);
+        h.add(cfg.GlyphOffset);
+        h.add(cfg.GlyphMinAdvanceX);
+        h.add(cfg.GlyphMaxAdvanceX);
+        h.add(cfg.MergeMode);
+        h.add(cfg.FontBuilderFlags);
+        h.add(cfg.RasterizerMultiply);
+        h.add(cfg.EllipsisChar);
+        for (auto range = cfg.GlyphRanges; range && range[0]; range += 2) {
+            h.add(range[0]);
+            h.add(range[1]);
+        }
+    }
+    for (const auto &rect : atlas.CustomRects) {
+        h.add(rect.Width);
+        h.add(rect.Height);
+        h.add(rect.GlyphID);
+        h.add(rect.GlyphAdvanceX);
+        h.add(rect.GlyphOffset);
+    }
+    return h.value;
+}
+
+int fontIndex(const ImFontAtlas &atlas, const ImFont *font) {
+    for (int i = 0; i < atlas.Fonts.Size; ++i) {
+        if (atlas.Fonts[i] == font) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+struct Writer {
+    std::vector<uint8_t> data;
+
+    void                 write(const void *p, size_t size) {
+        data.insert(data.end(), static_cast<const uint8_t *>(p), static_cast<const uint8_t *>(p) + size);
+    }
+    template<typename T>
+    void write(const T &v) {
+        write(&v, sizeof(T));
+    }
+};
+
+struct Reader {
+    std::vector<uint8_t> data;
+    size_t               pos = 0;
+    bool                 ok  = true;
+
+    bool                 read(void *p, size_t size) {
+        ok = ok && size <= data.size() - pos;
+        if (ok) {
+            std::memcpy(p, data.data() + pos, size);
+            pos += size;
+        }
+        return ok;
+    }
+    template<typename T>
+    T read() {
+        T v = {};
+        read(&v, sizeof(T));
+        return v;
+    }
+};
+
+} // namespace
+
+std::string defaultPath() {
+    if (auto cache = std::getenv("XDG_CACHE_HOME"); cache && *cache) {
+        return fmt::format("{}/imchart/fontatlas.bin", cache);
+    }
+    if (auto home = std::getenv("HOME"); home && *home) {
+        return fmt::format("{}/.cache/imchart/fontatlas.bin", home);
+    }
+    return {};
+}
+
+bool load(ImFontAtlas &atlas, const std::string &path) {
+    if (path.empty() || atlas.ConfigData.empty() || atlas.IsBuilt()) {
+        return false;
+    }
+
+    auto file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    Reader r;
+    std::fseek(file, 0, SEEK_END);
+    r.data.resize(std::max<long>(std::ftell(file), 0));
+    std::fseek(file, 0, SEEK_SET);
+    r.ok = std::fread(r.data.data(), 1, r.data.size(), file) == r.data.size();
+    std::fclose(file);
+
+    if (r.read<uint32_t>() != MAGIC || r.read<uint64_t>() != atlasKey(atlas)) {
+        return false;
+    }
+
+    const auto width  = r.read<int>();
+    const auto height = r.read<int>();
+    const auto white  = r.read<ImVec2>();
+    ImVec4     lines[IM_ARRAYSIZE(atlas.TexUvLines)];
+    r.read(lines, sizeof(lines));
+    const auto packIdMouseCursors = r.read<int>();
+    const auto packIdLines        = r.read<int>();
+
+    std::vector<ImFontAtlasCustomRect> rects(r.read<uint32_t>());
+    if (!r.ok || rects.size() > r.data.size()) {
+        return false;
+    }
+    for (auto &rect : rects) {
+        rect.Width         = r.read<unsigned short>();
+        rect.Height        = r.read<unsigned short>();
+        rect.X             = r.read<unsigned short>();
+        rect.Y             = r.read<unsigned short>();
+        rect.GlyphID       = r.read<unsigned int>();
+        rect.GlyphAdvanceX = r.read<float>();
+        rect.GlyphOffset   = r.read<ImVec2>();
+        const auto font    = r.read<int>();
+        rect.Font          = font >= 0 && font < atlas.Fonts.Size ? atlas.Fonts[font] : nullptr;
+    }
+
+    struct FontData {
+        float                     ascent;
+        float                     descent;
+        ImWchar                   ellipsisChar;
+        std::vector<ImFontGlyph> glyphs;
+    };
+    std::vector<FontData> fonts(r.read<uint32_t>());
+    if (!r.ok || fonts.size() != size_t(atlas.Fonts.Size)) {
+        return false;
+    }
+    for (auto &font : fonts) {
+        font.ascent       = r.read<float>();
+        font.descent      = r.read<float>();
+        font.ellipsisChar = r.read<ImWchar>();
+        const auto count  = r.read<uint32_t>();
+        if (!r.ok || count > r.data.size() / sizeof(ImFontGlyph)) {
+            return false;
+        }
+        font.glyphs.resize(count);
+        r.read(font.glyphs.data(), count * sizeof(ImFontGlyph));
+    }
+
+    const size_t pixels = size_t(std::max(width, 0)) * std::max(height, 0);
+    if (!r.ok || pixels == 0 || r.data.size() - r.pos != pixels) {
+        fmt::print(stderr, "Ignoring the corrupt font atlas cache '{}'.\n", path);
+        return false;
+    }
+
+    // Everything read, now restore what ImFontAtlas::Build() would have produced
+    atlas.ClearTexData();
+    atlas.TexPixelsAlpha8 = static_cast<unsigned char *>(IM_ALLOC(pixels));
+    r.read(atlas.TexPixelsAlpha8, pixels);
+    atlas.TexWidth        = width;
+    atlas.TexHeight       = height;
+    atlas.TexUvScale      = ImVec2(1.0f / width, 1.0f / height);
+    atlas.TexUvWhitePixel = white;
+    std::memcpy(atlas.TexUvLines, lines, sizeof(lines));
+    atlas.PackIdMouseCursors = packIdMouseCursors;
+    atlas.PackIdLines        = packIdLines;
+    atlas.CustomRects.resize(int(rects.size()));
+    std::copy(rects.begin(), rects.end(), atlas.CustomRects.begin());
+
+    for (auto font : atlas.Fonts) {
+        font->ClearOutputData();
+        font->ContainerAtlas  = &atlas;
+        font->ConfigData      = nullptr;
+        font->ConfigDataCount = 0;
+    }
+    // merged fonts have their configurations right after the one of the font they merge into
+    for (auto &cfg : atlas.ConfigData) {
+        if (!cfg.DstFont->ConfigData) {
+            cfg.DstFont->ConfigData = &cfg;
+            cfg.DstFont->FontSize   = cfg.SizePixels;
+        }
+        ++cfg.DstFont->ConfigDataCount;
+    }
+    for (int i = 0; i < atlas.Fonts.Size; ++i) {
+        auto        font = atlas.Fonts[i];
+        const auto &data = fonts[i];
+        font->Ascent     = data.ascent;
+        font->Descent    = data.descent;
+        font->Glyphs.resize(int(data.glyphs.size()));
+        std::copy(data.glyphs.begin(), data.glyphs.end(), font->Glyphs.begin());
+        font->BuildLookupTable();
+        font->EllipsisChar = data.ellipsisChar;
+    }
+    atlas.TexReady = true;
+    return true;
+}
+
+bool save(const ImFontAtlas &atlas, const std::string &path) {
+    // colored glyphs would need the RGBA texture, which is not worth caching
+    if (path.empty() || !atlas.IsBuilt() || !atlas.TexPixelsAlpha8 || atlas.TexPixelsUseColors) {
+        return false;
+    }
+
+    Writer w;
+    w.write(MAGIC);
+    w.write(atlasKey(atlas));
+    w.write(atlas.TexWidth);
+    w.write(atlas.TexHeight);
+    w.write(atlas.TexUvWhitePixel);
+    w.write(atlas.TexUvLines, sizeof(atlas.TexUvLines));
+    w.write(atlas.PackIdMouseCursors);
+    w.write(atlas.PackIdLines);
+
+    w.write(uint32_t(atlas.CustomRects.Size));
+    for (const auto &rect : atlas.CustomRects) {
+        w.write(rect.Width);
+        w.write(rect.Height);
+        w.write(rect.X);
+        w.write(rect.Y);
+        w.write(rect.GlyphID);
+        w.write(rect.GlyphAdvanceX);
+        w.write(rect.GlyphOffset);
+        w.write(fontIndex(atlas, rect.Font));
+    }
+
+    w.write(uint32_t(atlas.Fonts.Size));
+    for (const auto font : atlas.Fonts) {
+        w.write(font->Ascent);
+        w.write(font->Descent);
+        w.write(font->EllipsisChar);
+        w.write(uint32_t(font->Glyphs.Size));
+        w.write(font->Glyphs.Data, font->Glyphs.Size * sizeof(ImFontGlyph));
+    }
+    w.write(atlas.TexPixelsAlpha8, size_t(atlas.TexWidth) * atlas.TexHeight);
+
+    // write to a temporary file first, so concurrently starting processes never read a partial file
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    const auto tmp  = fmt::format("{}.{}", path, std::chrono::steady_clock::now().time_since_epoch().count());
+    auto       file = std::fopen(tmp.c_str(), "wb");
+    if (!file) {
+        fmt::print(stderr, "Unable to write the font atlas cache '{}'.\n", path);
+        return false;
+    }
+    const bool ok = std::fwrite(w.data.data(), 1, w.data.size(), file) == w.data.size();
+    std::fclose(file);
+    std::filesystem::rename(tmp, path, error);
+    if (!ok || error) {
+        fmt::print(stderr, "Unable to write the font atlas cache '{}'.\n", path);
+        std::filesystem::remove(tmp, error);
+        return false;
+    }
+    return true;
+}
+
+} // namespace ImChart::FontAtlasCache
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+
+struct ImFontAtlas;
+
+namespace ImChart {
+
+/**
+ * On disk cache of a built ImFontAtlas, to skip rasterizing the fonts at startup.
+ *
+ * The fonts must have been added to the atlas (e.g. with AddFontDefault()) but not built yet.
+ * The cache is keyed by the font data and configuration of the atlas and the ImGui version, so a
+ * stale file is simply not used.
+ */
+namespace FontAtlasCache {
+
+// $XDG_CACHE_HOME/imchart/fontatlas.bin, or ~/.cache/imchart/fontatlas.bin
+std::string defaultPath();
+
+// Restores the built atlas from 'path'. Returns false if there is no matching cache entry.
+bool        load(ImFontAtlas &atlas, const std::string &path);
+// Writes the built atlas to 'path'
+bool        save(const ImFontAtlas &atlas, const std::string &path);
+
+} // namespace FontAtlasCache
+
+} // namespace ImChart
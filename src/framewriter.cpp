@@ -0,0 +1,186 @@
+#include "framewriter.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace ImChart {
+
+namespace {
+
+const std::array<uint32_t, 256> &crcTable() {
+    static const auto table = []() {
+        std::array<uint32_t, 256> t;
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            t[n] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+uint32_t crc32(uint32_t crc, const uint8_t *data, size_t size) {
+    const auto &table = crcTable();
+    crc               = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void appendBE32(std::vector<uint8_t> &out, uint32_t v) {
+    out.insert(out.end(), { uint8_t(v >> 24), uint8_t(v >> 16), uint8_t(v >> 8), uint8_t(v) });
+}
+
+void appendChunk(std::vector<uint8_t> &out, const char *type, const std::vector<uint8_t> &data) {
+    appendBE32(out, uint32_t(data.size()));
+    const size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    appendBE32(out, crc32(0, out.data() + start, out.size() - start));
+}
+
+// PNG with the image data in stored (uncompressed) deflate blocks
+std::vector<uint8_t> encodePng(const Renderer::CapturedFrame &frame) {
+    const int    w      = frame.size.width;
+    const int    h      = frame.size.height;
+    const size_t stride = size_t(w) * 4;
+
+    // scanlines top to bottom, each prefixed with filter type 0
+    std::vector<uint8_t> raw;
+    raw.reserve((stride + 1) * h);
+    for (int y = h - 1; y >= 0; --y) {
+        const auto *row = reinterpret_cast<const uint8_t *>(frame.pixels.data() + size_t(y) * w);
+        raw.push_back(0);
+        raw.insert(raw.end(), row, row + stride);
+    }
+
+    std::vector<uint8_t> zlib = { 0x78, 0x01 };
+    zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    for (size_t pos = 0; pos < raw.size() || pos == 0;) {
+        const size_t   len  = std::min<size_t>(65535, raw.size() - pos);
+        const bool     last = pos + len == raw.size();
+        const uint16_t n    = uint16_t(len);
+        zlib.insert(zlib.end(), { uint8_t(last ? 1 : 0), uint8_t(n), uint8_t(n >> 8), uint8_t(~n), uint8_t(~n >> 8) });
+        zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + len);
+        pos += len;
+        if (last) {
+            break;
+        }
+    }
+    uint32_t a = 1, b = 0;
+    for (const auto byte : raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    appendBE32(zlib, (b << 16) | a);
+
+    std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    std::vector<uint8_t> header;
+    appendBE32(header, w);
+    appendBE32(header, h);
+    header.insert(header.end(), { 8, 6, 0, 0, 0 }); // 8 bit RGBA, no interlacing
+    appendChunk(png, "IHDR", header);
+    appendChunk(png, "IDAT", zlib);
+    appendChunk(png, "IEND", {});
+    return png;
+}
+
+} // namespace
+
+FrameWriter::FrameWriter(std::string pattern, Format format, size_t maxQueued)
+    : m_pattern(std::move(pattern))
+    , m_format(format)
+    , m_maxQueued(maxQueued) {
+    // a format error thrown on the writer thread would terminate the application
+    try {
+        (void) fmt::format(fmt::runtime(m_pattern), uint64_t(0));
+    } catch (const fmt::format_error &e) {
+        const auto fallback = m_format == Format::Png ? "frame-{:06}.png" : "frame-{:06}.pam";
+        fmt::print(stderr, "Invalid frame file name pattern '{}' ({}), using '{}'.\n", m_pattern, e.what(), fallback);
+        m_pattern = fallback;
+    }
+    m_thread = std::thread([this]() { run(); });
+}
+
+FrameWriter::~FrameWriter() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_quit = true;
+    }
+    m_condition.notify_one();
+    m_thread.join();
+}
+
+bool FrameWriter::push(Renderer::CapturedFrame &&frame) {
+    if (frame.pixels.size() < size_t(frame.size.width) * frame.size.height) {
+        // a failed readback
+        ++m_dropped;
+        return false;
+    }
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_queue.size() >= m_maxQueued) {
+            ++m_dropped;
+            return false;
+        }
+        m_queue.push_back(std::move(frame));
+    }
+    m_condition.notify_one();
+    return true;
+}
+
+void FrameWriter::run() {
+    for (;;) {
+        Renderer::CapturedFrame frame;
+        {
+            std::unique_lock lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_quit || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                return;
+            }
+            frame = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        if (write(frame)) {
+            ++m_written;
+        }
+    }
+}
+
+bool FrameWriter::write(const Renderer::CapturedFrame &frame) {
+    const auto path = fmt::format(fmt::runtime(m_pattern), frame.number);
+    auto       file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        fmt::print(stderr, "Unable to open '{}' for writing the captured frame.\n", path);
+        return false;
+    }
+
+    bool ok = true;
+    if (m_format == Format::Png) {
+        const auto png = encodePng(frame);
+        ok             = std::fwrite(png.data(), 1, png.size(), file) == png.size();
+    } else {
+        const auto w      = frame.size.width;
+        const auto h      = frame.size.height;
+        const auto header = fmt::format("P7\nWIDTH {}\nHEIGHT {}\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n", w, h);
+        ok                = std::fwrite(header.data(), 1, header.size(), file) == header.size();
+        for (int y = h - 1; ok && y >= 0; --y) {
+            ok = std::fwrite(frame.pixels.data() + size_t(y) * w, 4, w, file) == size_t(w);
+        }
+    }
+    std::fclose(file);
+    if (!ok) {
+        fmt::print(stderr, "Failed to write the captured frame to '{}'.\n", path);
+    }
+    return ok;
+}
+
+} // namespace ImChart
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "renderers/renderer.h"
+
+namespace ImChart {
+
+/**
+ * Writes captured frames to an image sequence on a background thread.
+ *
+ * push() only moves the frame into a queue, so it can be passed directly as the callback of
+ * Renderer::Surface::captureNextFrame(). If the disk cannot keep up and the queue is full, frames
+ * are dropped rather than piling up in memory.
+ *
+ * The file name of a frame is 'pattern' formatted with the frame number, e.g. "frame-{:06}.png".
+ * An invalid pattern is reported and replaced by "frame-{:06}" with the extension of the format.
+ * PNG files are stored uncompressed, which costs no CPU time on the writer thread and needs no
+ * zlib; Raw writes PAM files, a short text header followed by the RGBA bytes.
+ */
+class FrameWriter {
+public:
+    enum class Format {
+        Png,
+        Raw
+    };
+
+    FrameWriter(std::string pattern, Format format, size_t maxQueued = 8);
+    // Writes the frames still queued
+    ~FrameWriter();
+
+    // Thread safe. Returns false if the frame was dropped.
+    bool     push(Renderer::CapturedFrame &&frame);
+
+    uint64_t written() const { return m_written; }
+    uint64_t dropped() const { return m_dropped; }
+
+private:
+    void                                run();
+    bool                                write(const Renderer::CapturedFrame &frame);
+
+    std::string                         m_pattern;
+    Format                              m_format;
+    size_t                              m_maxQueued;
+    std::mutex                          m_mutex;
+    std::condition_variable             m_condition;
+    std::deque<Renderer::CapturedFrame> m_queue;
+    bool                                m_quit    = false;
+    std::atomic<uint64_t>               m_written = 0;
+    std::atomic<uint64_t>               m_dropped = 0;
+    std::thread                         m_thread;
+};
+
+} // namespace ImChart
@@ -0,0 +1,228 @@
+#include "histogramdataset.h"
+
+#include <algorithm>
+
+#include "parallel.h"
+
+namespace ImChart {
+
+namespace {
+
+// Events are binned in blocks, so the index computation runs over contiguous arrays and vectorizes
+constexpr int    BLOCK     = 256;
+// Batches smaller than this are not worth spreading over several threads
+constexpr size_t MIN_CHUNK = 1 << 16;
+
+void             mergeCounts(std::vector<uint64_t> &counts, const std::vector<uint32_t> &partial) {
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (partial[i]) {
+            std::atomic_ref<uint64_t>(counts[i]).fetch_add(partial[i], std::memory_order_relaxed);
+        }
+    }
+}
+
+} // namespace
+
+Binning Binning::fixed(int bins, float min, float max) {
+    Binning b;
+    b.m_bins     = std::max(1, bins);
+    b.m_min      = min;
+    b.m_max      = max;
+    b.m_invWidth = b.m_bins / (max - min);
+    return b;
+}
+
+Binning Binning::variable(std::vector<float> edges) {
+    std::sort(edges.begin(), edges.end());
+    if (edges.size() < 2) {
+        return fixed(1, edges.empty() ? 0 : edges.front(), edges.empty() ? 1 : edges.front() + 1);
+    }
+    Binning b;
+    b.m_bins  = int(edges.size()) - 1;
+    b.m_min   = edges.front();
+    b.m_max   = edges.back();
+    b.m_edges = std::move(edges);
+    return b;
+}
+
+float Binning::lowerEdge(int bin) const {
+    return m_edges.empty() ? m_min + bin / m_invWidth : m_edges[bin];
+}
+
+float Binning::upperEdge(int bin) const {
+    return m_edges.empty() ? m_min + (bin + 1) / m_invWidth : m_edges[bin + 1];
+}
+
+void Binning::indices(const float *values, int count, int32_t *out) const {
+    if (m_edges.empty()) {
+        // Clamp to [-1, bins] before shifting so the truncating conversion acts as floor().
+        // The inverted first comparison also sends NaN to the underflow.
+        const float lo = -1.f;
+        const float hi = float(m_bins);
+        for (int i = 0; i < count; ++i) {
+            float f = (values[i] - m_min) * m_invWidth;
+            f       = f >= lo ? f : lo;
+            f       = f <= hi ? f : hi;
+            out[i]  = int32_t(f + 1.f);
+        }
+        return;
+    }
+
+    // Branchless upper bound: the shifted index is the number of edges <= value. All values take
+    // the same number of steps, so the loop has no data dependent branches.
+    const float *edges = m_edges.data();
+    const size_t size  = m_edges.size();
+    for (int i = 0; i < count; ++i) {
+        const float  v    = values[i];
+        const float *base = edges;
+        size_t       n    = size;
+        while (n > 1) {
+            const size_t half = n / 2;
+            base              = base[half] <= v ? base + half : base;
+            n -= half;
+        }
+        out[i] = int32_t(base - edges) + (*base <= v ? 1 : 0);
+    }
+}
+
+HistogramDataSet::HistogramDataSet(Binning binning)
+    : m_binning(std::move(binning))
+    , m_counts(m_binning.bins() + 2) {
+    const int bins = m_binning.bins();
+    _centers.resize(bins);
+    _contents.resize(bins);
+    for (int i = 0; i < bins; ++i) {
+        _centers[i] = m_binning.center(i);
+    }
+}
+
+HistogramDataSet::~HistogramDataSet() {
+}
+
+float HistogramDataSet::get(int dimIndex, int index) const {
+    return (dimIndex == 0 ? _centers : _contents)[index];
+}
+
+std::span<float> HistogramDataSet::getValues(int dimIndex) {
+    return dimIndex == 0 ? _centers : _contents;
+}
+
+size_t HistogramDataSet::memoryUsage() const {
+    return ImChart::memoryUsage(_centers) + ImChart::memoryUsage(_contents) + m_counts.capacity() * sizeof(uint64_t);
+}
+
+uint64_t HistogramDataSet::underflow() const {
+    return std::atomic_ref<uint64_t>(const_cast<uint64_t &>(m_counts.front())).load(std::memory_order_relaxed);
+}
+
+uint64_t HistogramDataSet::overflow() const {
+    return std::atomic_ref<uint64_t>(const_cast<uint64_t &>(m_counts.back())).load(std::memory_order_relaxed);
+}
+
+void HistogramDataSet::fill(std::span<const float> values) {
+    parallelFor(values.size(), MIN_CHUNK, [&](size_t begin, size_t end, int) {
+        std::vector<uint32_t> partial(m_counts.size());
+        int32_t               idx[BLOCK];
+        for (size_t i = begin; i < end; i += BLOCK) {
+            const int n = int(std::min<size_t>(BLOCK, end - i));
+            m_binning.indices(values.data() + i, n, idx);
+            for (int j = 0; j < n; ++j) {
+                ++partial[idx[j]];
+            }
+        }
+        mergeCounts(m_counts, partial);
+    }, "histogram fill");
+    m_entries.fetch_add(values.size(), std::memory_order_relaxed);
+}
+
+void HistogramDataSet::publish() {
+    const int bins = m_binning.bins();
+    for (int i = 0; i < bins; ++i) {
+        _contents[i] = float(std::atomic_ref<uint64_t>(m_counts[i + 1]).load(std::memory_order_relaxed));
+    }
+    dataChanged(0, bins);
+}
+
+void HistogramDataSet::reset() {
+    for (auto &c : m_counts) {
+        std::atomic_ref<uint64_t>(c).store(0, std::memory_order_relaxed);
+    }
+    m_entries = 0;
+}
+
+HistogramDataSet2D::HistogramDataSet2D(Binning xBinning, Binning yBinning)
+    : m_xBinning(std::move(xBinning))
+    , m_yBinning(std::move(yBinning))
+    , m_counts(size_t(m_xBinning.bins()) * m_yBinning.bins()) {
+    _xcenters.resize(m_xBinning.bins());
+    _ycenters.resize(m_yBinning.bins());
+    _contents.resize(m_counts.size());
+    for (int i = 0; i < m_xBinning.bins(); ++i) {
+        _xcenters[i] = m_xBinning.center(i);
+    }
+    for (int i = 0; i < m_yBinning.bins(); ++i) {
+        _ycenters[i] = m_yBinning.center(i);
+    }
+}
+
+HistogramDataSet2D::~HistogramDataSet2D() {
+}
+
+float HistogramDataSet2D::get(int dimIndex, int index) const {
+    return (dimIndex == 0 ? _xcenters : dimIndex == 1 ? _ycenters : _contents)[index];
+}
+
+std::span<float> HistogramDataSet2D::getValues(int dimIndex) {
+    return dimIndex == 0 ? _xcenters : (dimIndex == 1 ? _ycenters : _contents);
+}
+
+size_t HistogramDataSet2D::memoryUsage() const {
+    return ImChart::memoryUsage(_xcenters) + ImChart::memoryUsage(_ycenters) + ImChart::memoryUsage(_contents) + m_counts.capacity() * sizeof(uint64_t);
+}
+
+void HistogramDataSet2D::fill(std::span<const float> xs, std::span<const float> ys) {
+    const size_t count = std::min(xs.size(), ys.size());
+    const int    nx    = m_xBinning.bins();
+    const int    ny    = m_yBinning.bins();
+    const auto   cells = int32_t(m_counts.size());
+
+    parallelFor(count, MIN_CHUNK, [&](size_t begin, size_t end, int) {
+        // the last slot collects the outliers
+        std::vector<uint32_t> partial(cells + 1);
+        int32_t               ix[BLOCK];
+        int32_t               iy[BLOCK];
+        for (size_t i = begin; i < end; i += BLOCK) {
+            const int n = int(std::min<size_t>(BLOCK, end - i));
+            m_xBinning.indices(xs.data() + i, n, ix);
+            m_yBinning.indices(ys.data() + i, n, iy);
+            for (int j = 0; j < n; ++j) {
+                const bool inside = ix[j] >= 1 && ix[j] <= nx && iy[j] >= 1 && iy[j] <= ny;
+                ix[j]             = inside ? (iy[j] - 1) * nx + ix[j] - 1 : cells;
+            }
+            for (int j = 0; j < n; ++j) {
+                ++partial[ix[j]];
+            }
+        }
+        m_outliers.fetch_add(partial.back(), std::memory_order_relaxed);
+        partial.pop_back();
+        mergeCounts(m_counts, partial);
+    }, "histogram 2d fill");
+    m_entries.fetch_add(count, std::memory_order_relaxed);
+}
+
+void HistogramDataSet2D::publish() {
+    for (size_t i = 0; i < m_counts.size(); ++i) {
+        _contents[i] = float(std::atomic_ref<uint64_t>(m_counts[i]).load(std::memory_order_relaxed));
+    }
+    dataChanged(0, getDataCount());
+}
+
+void HistogramDataSet2D::reset() {
+    for (auto &c : m_counts) {
+        std::atomic_ref<uint64_t>(c).store(0, std::memory_order_relaxed);
+    }
+    m_outliers = 0;
+    m_entries  = 0;
+}
+
+} // namespace ImChart
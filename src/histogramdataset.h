@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "storage.h"
+#include <dataset.h>
+
+namespace ImChart {
+
+/**
+ * Bin edges of one histogram axis, either equidistant or variable.
+ *
+ * Bin indices are shifted by one: 0 counts the underflow, 1..bins() the regular bins and
+ * bins() + 1 the overflow.
+ */
+class Binning {
+public:
+    static Binning fixed(int bins, float min, float max);
+    static Binning variable(std::vector<float> edges);
+
+    int            bins() const { return m_bins; }
+    float          lowerEdge(int bin) const;
+    float          upperEdge(int bin) const;
+    float          center(int bin) const { return 0.5f * (lowerEdge(bin) + upperEdge(bin)); }
+
+    // Computes the shifted bin indices of 'count' values
+    void           indices(const float *values, int count, int32_t *out) const;
+
+private:
+    int                m_bins     = 0;
+    float              m_min      = 0;
+    float              m_max      = 0;
+    float              m_invWidth = 0;
+    std::vector<float> m_edges; // empty for fixed binning
+};
+
+/**
+ * 1D histogram. Dimension 0 holds the bin centers, dimension 1 the bin contents.
+ *
+ * fill() can be called from any thread and splits large batches over all cores. Every worker
+ * counts into its own partial histogram, which is then merged into the shared counters with
+ * atomic adds. The counters are only converted to the float values returned by getValues() in
+ * publish(), which must be called on the UI thread and emits dataChanged().
+ */
+class HistogramDataSet : public DataSet {
+public:
+    explicit HistogramDataSet(Binning binning);
+    ~HistogramDataSet();
+
+    float            get(int dimIndex, int index) const final;
+    int              getDataCount() const final { return m_binning.bins(); }
+    int              getDimension() const final { return 2; }
+    std::span<float> getValues(int dimIndex) final;
+
+    size_t           memoryUsage() const final;
+
+    const Binning   &binning() const { return m_binning; }
+    uint64_t         underflow() const;
+    uint64_t         overflow() const;
+    uint64_t         entries() const { return m_entries.load(std::memory_order_relaxed); }
+
+    void             fill(std::span<const float> values);
+    void             publish();
+    void             reset();
+
+private:
+    Binning               m_binning;
+    std::vector<uint64_t> m_counts; // including under- and overflow
+    std::atomic<uint64_t> m_entries = 0;
+    FloatStorage          _centers;
+    FloatStorage          _contents;
+};
+
+/**
+ * 2D histogram. Dimensions 0 and 1 hold the x and y bin centers, dimension 2 the bin contents
+ * row by row, i.e. the content of bin (ix, iy) is at index iy * xBins + ix.
+ *
+ * Entries falling into an under- or overflow bin of either axis are counted in outliers() only.
+ * Threading works as for HistogramDataSet.
+ */
+class HistogramDataSet2D : public DataSet {
+public:
+    HistogramDataSet2D(Binning xBinning, Binning yBinning);
+    ~HistogramDataSet2D();
+
+    float            get(int dimIndex, int index) const final;
+    int              getDataCount() const final { return m_xBinning.bins() * m_yBinning.bins(); }
+    int              getDimension() const final { return 3; }
+    std::span<float> getValues(int dimIndex) final;
+
+    size_t           memoryUsage() const final;
+
+    const Binning   &xBinning() const { return m_xBinning; }
+    const Binning   &yBinning() const { return m_yBinning; }
+    uint64_t         outliers() const { return m_outliers.load(std::memory_order_relaxed); }
+    uint64_t         entries() const { return m_entries.load(std::memory_order_relaxed); }
+
+    void             fill(std::span<const float> xs, std::span<const float> ys);
+    void             publish();
+    void             reset();
+
+private:
+    Binning               m_xBinning;
+    Binning               m_yBinning;
+    std::vector<uint64_t> m_counts;
+    std::atomic<uint64_t> m_outliers = 0;
+    std::atomic<uint64_t> m_entries  = 0;
+    FloatStorage          _xcenters;
+    FloatStorage          _ycenters;
+    FloatStorage          _contents;
+};
+
+} // namespace ImChart
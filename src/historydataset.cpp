@@ -0,0 +1,225 @@
+#include "historydataset.h"
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <new>
+
+#include "floatcodec.h"
+
+namespace ImChart {
+
+namespace {
+
+void updateSummary(DataSet::SegmentSummary &summary, const float *values, int count) {
+    float lo = summary.min;
+    float hi = summary.max;
+    for (int i = 0; i < count; ++i) {
+        lo = std::min(lo, values[i]);
+        hi = std::max(hi, values[i]);
+    }
+    summary.min = lo;
+    summary.max = hi;
+    summary.count += count;
+}
+
+} // namespace
+
+HistoryDataSet::HistoryDataSet(int blockSize, int rawBlocks, int cachedBlocks)
+    : m_blockSize(std::max(1, blockSize))
+    , m_rawBlocks(std::max(1, rawBlocks))
+    , m_cachedBlocks(std::max(2, cachedBlocks)) {
+}
+
+HistoryDataSet::~HistoryDataSet() {
+    clear();
+}
+
+float HistoryDataSet::get(int dimIndex, int index) const {
+    const int   block = index / m_blockSize;
+    const auto &b     = m_blocks[block];
+    if (b.values[dimIndex]) {
+        return b.values[dimIndex][index % m_blockSize];
+    }
+    return decoded(block, dimIndex)[index % m_blockSize];
+}
+
+std::span<float> HistoryDataSet::getValues(int dimIndex) {
+    if (m_blocks.size() != 1) {
+        return {};
+    }
+    return getSegment(dimIndex, 0);
+}
+
+std::span<float> HistoryDataSet::getSegment(int dimIndex, int segment) {
+    const auto &b = m_blocks[segment];
+    if (b.values[dimIndex]) {
+        return { b.values[dimIndex], size_t(b.summary[dimIndex].count) };
+    }
+    return decoded(segment, dimIndex);
+}
+
+const DataSet::SegmentSummary *HistoryDataSet::getSegmentSummary(int dimIndex, int segment) const {
+    return &m_blocks[segment].summary[dimIndex];
+}
+
+size_t HistoryDataSet::memoryUsage() const {
+    size_t bytes = m_blocks.capacity() * sizeof(Block);
+    for (const auto &b : m_blocks) {
+        for (int d = 0; d < 2; ++d) {
+            bytes += b.values[d] ? m_blockSize * sizeof(float) : b.packed[d].capacity() * sizeof(uint32_t);
+        }
+    }
+    return bytes + m_cacheBytes;
+}
+
+HistoryDataSet::Stats HistoryDataSet::stats() const {
+    Stats stats;
+    stats.compressedBlocks = m_compressed;
+    for (int i = 0; i < m_compressed; ++i) {
+        for (int d = 0; d < 2; ++d) {
+            stats.compressedBytes += m_blocks[i].packed[d].size() * sizeof(uint32_t);
+            stats.uncompressedBytes += m_blocks[i].summary[d].count * sizeof(float);
+        }
+    }
+    stats.cacheHits   = m_cacheHits;
+    stats.cacheMisses = m_cacheMisses;
+    return stats;
+}
+
+void HistoryDataSet::append(std::span<const float> xs, std::span<const float> ys) {
+    const int count = int(std::min(xs.size(), ys.size()));
+    const int start = m_count;
+    int       done  = 0;
+    try {
+        // readers on other threads index the block table while it grows, see DataSet::storageLock()
+        std::unique_lock lock(storageLock());
+        while (done < count) {
+            if (m_blocks.empty() || m_blocks.back().summary[0].count == m_blockSize) {
+                Block b;
+                for (int d = 0; d < 2; ++d) {
+                    b.values[d]  = static_cast<float *>(Storage::allocate(m_blockSize * sizeof(float)));
+                    b.summary[d] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(), 0 };
+                }
+                // the block is only owned once it is in the table, which can fail to grow as well
+                const auto release = [&]() {
+                    Storage::deallocate(b.values[0], m_blockSize * sizeof(float));
+                    Storage::deallocate(b.values[1], m_blockSize * sizeof(float));
+                };
+                if (!b.values[0] || !b.values[1]) {
+                    release();
+                    throw std::bad_alloc();
+                }
+                try {
+                    m_blocks.push_back(std::move(b));
+                } catch (...) {
+                    release();
+                    throw;
+                }
+            }
+
+            auto     &b      = m_blocks.back();
+            const int filled = b.summary[0].count;
+            const int n      = std::min(count - done, m_blockSize - filled);
+            std::copy_n(xs.data() + done, n, b.values[0] + filled);
+            std::copy_n(ys.data() + done, n, b.values[1] + filled);
+            updateSummary(b.summary[0], xs.data() + done, n);
+            updateSummary(b.summary[1], ys.data() + done, n);
+            done += n;
+            m_count += n;
+        }
+
+        // the blocks behind the most recent ones are full and never change again
+        while (int(m_blocks.size()) - m_compressed > m_rawBlocks) {
+            compress(m_blocks[m_compressed++]);
+        }
+    } catch (...) {
+        // the points appended before an allocation failed stay
+        if (done > 0) {
+            dataChanged(start, done);
+        }
+        throw;
+    }
+    dataChanged(start, count);
+}
+
+void HistoryDataSet::compress(Block &block) {
+    for (int d = 0; d < 2; ++d) {
+        FloatCodec::encode({ block.values[d], size_t(block.summary[d].count) }, block.packed[d]);
+        block.packed[d].shrink_to_fit();
+        Storage::deallocate(block.values[d], m_blockSize * sizeof(float));
+        block.values[d] = nullptr;
+    }
+}
+
+void HistoryDataSet::clear() {
+    bool hadData;
+    {
+        std::unique_lock lock(storageLock());
+        for (auto &b : m_blocks) {
+            for (int d = 0; d < 2; ++d) {
+                if (b.values[d]) {
+                    Storage::deallocate(b.values[d], m_blockSize * sizeof(float));
+                }
+            }
+        }
+        m_blocks.clear();
+        m_compressed = 0;
+        {
+            std::lock_guard cacheLock(m_cacheMutex);
+            m_caches.clear();
+            m_cacheBytes = 0;
+        }
+        hadData = m_count > 0;
+        m_count = 0;
+    }
+    if (hadData) {
+        dataChanged(0, 0);
+    }
+}
+
+HistoryDataSet::ThreadCache &HistoryDataSet::threadCache() const {
+    const auto      self = std::this_thread::get_id();
+    std::lock_guard lock(m_cacheMutex);
+    for (auto &cache : m_caches) {
+        if (cache->thread == self) {
+            return *cache;
+        }
+    }
+    auto &cache  = *m_caches.emplace_back(std::make_unique<ThreadCache>());
+    cache.thread = self;
+    cache.entries.reserve(m_cachedBlocks);
+    return cache;
+}
+
+std::span<float> HistoryDataSet::decoded(int block, int dimIndex) const {
+    // only this thread touches its cache, the lookup does not need the lock
+    auto        &cache = threadCache();
+    const size_t count = size_t(m_blocks[block].summary[dimIndex].count);
+    for (auto &e : cache.entries) {
+        if (e.block == block && e.dimIndex == dimIndex) {
+            e.lastUse = ++cache.uses;
+            ++m_cacheHits;
+            return { e.values.data(), count };
+        }
+    }
+    ++m_cacheMisses;
+
+    CacheEntry *entry;
+    if (int(cache.entries.size()) < m_cachedBlocks) {
+        entry = &cache.entries.emplace_back();
+    } else {
+        entry = &*std::min_element(cache.entries.begin(), cache.entries.end(), [](const auto &a, const auto &b) { return a.lastUse < b.lastUse; });
+    }
+    entry->block    = block;
+    entry->dimIndex = dimIndex;
+    entry->lastUse  = ++cache.uses;
+    // the entries are reused, their capacity only grows
+    const size_t capacity = ImChart::memoryUsage(entry->values);
+    entry->values.resize(count);
+    m_cacheBytes += ImChart::memoryUsage(entry->values) - capacity;
+    FloatCodec::decode(m_blocks[block].packed[dimIndex], entry->values);
+    return { entry->values.data(), count };
+}
+
+} // namespace ImChart
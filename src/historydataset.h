@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "storage.h"
+#include <dataset.h>
+
+namespace ImChart {
+
+/**
+ * Append-only 2D data set for long recordings, keeping its history compressed in memory.
+ *
+ * Values are stored in fixed-size blocks like SegmentedDataSet. The most recent 'rawBlocks' blocks
+ * stay raw; older ones are compressed losslessly with FloatCodec and their raw values freed. Each
+ * block keeps the min/max summary of its values, so limits and decimation over whole blocks, as
+ * in overview zoom levels, never decompress anything.
+ *
+ * getSegment() of a compressed block decodes it into a per-thread LRU cache of 'cachedBlocks'
+ * decoded blocks and dimensions. The span stays valid until the same thread decoded
+ * 'cachedBlocks' other ones, so a caller can hold the x and y values of a segment at once.
+ * append() and clear() hold storageLock() exclusively, as compressing a block frees its raw
+ * values: readers on the thread pool hold it shared while they use a segment.
+ */
+class HistoryDataSet : public DataSet {
+public:
+    struct Stats {
+        int      compressedBlocks  = 0;
+        size_t   compressedBytes   = 0;
+        size_t   uncompressedBytes = 0; // size of the compressed blocks as raw floats
+        uint64_t cacheHits         = 0;
+        uint64_t cacheMisses       = 0;
+    };
+
+    explicit HistoryDataSet(int blockSize = 1 << 16, int rawBlocks = 4, int cachedBlocks = 8);
+    ~HistoryDataSet();
+
+    HistoryDataSet(const HistoryDataSet &) = delete;
+    HistoryDataSet &operator=(const HistoryDataSet &) = delete;
+
+    float                 get(int dimIndex, int index) const final;
+    int                   getDataCount() const final { return m_count; }
+    int                   getDimension() const final { return 2; }
+    std::span<float>      getValues(int dimIndex) final;
+
+    int                   getSegmentCount() const final { return int(m_blocks.size()); }
+    std::span<float>      getSegment(int dimIndex, int segment) final;
+    const SegmentSummary *getSegmentSummary(int dimIndex, int segment) const final;
+
+    size_t                memoryUsage() const final;
+    Stats                 stats() const;
+
+    int                   blockSize() const { return m_blockSize; }
+
+    // Throws std::bad_alloc if a block cannot be allocated, the points appended until then stay
+    void                  append(std::span<const float> xs, std::span<const float> ys);
+    void                  clear();
+
+private:
+    struct Block {
+        float                *values[2]; // nullptr once compressed
+        std::vector<uint32_t> packed[2];
+        SegmentSummary        summary[2];
+    };
+
+    struct CacheEntry {
+        int          block;
+        int          dimIndex;
+        uint64_t     lastUse;
+        FloatStorage values;
+    };
+
+    struct ThreadCache {
+        std::thread::id         thread;
+        uint64_t                uses = 0;
+        std::vector<CacheEntry> entries;
+    };
+
+    void                                               compress(Block &block);
+    std::span<float>                                   decoded(int block, int dimIndex) const;
+    ThreadCache                                       &threadCache() const;
+
+    int                                                m_blockSize;
+    int                                                m_rawBlocks;
+    int                                                m_cachedBlocks;
+    int                                                m_count      = 0;
+    int                                                m_compressed = 0; // blocks [0, m_compressed) are compressed
+    std::vector<Block>                                 m_blocks;
+
+    mutable std::mutex                                 m_cacheMutex;
+    mutable std::vector<std::unique_ptr<ThreadCache>>  m_caches;
+    mutable std::atomic<uint64_t>                      m_cacheHits   = 0;
+    mutable std::atomic<uint64_t>                      m_cacheMisses = 0;
+    // the threads change their caches without the lock, so their memory usage is counted here
+    mutable std::atomic<size_t>                        m_cacheBytes  = 0;
+};
+
+} // namespace ImChart
@@ -1,13 +1,30 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <string_view>
+#include <thread>
+#include <vector>
+
 #include <fmt/format.h>
 
 #include <imgui.h>
 #include <implot.h>
 
 #include "backends/backend.h"
+#include "fontatlascache.h"
+#include "plotitems.h"
 #include "renderers/renderer.h"
 #include "sindataset.h"
+#include "startup.h"
+#include "streamstatistics.h"
 #include "window.h"
 
+#ifndef EMSCRIPTEN
+#include "datasetlog.h"
+#include "remote.h"
+#include "shmdataset.h"
+#endif
+
 using namespace ImChart;
 
 bool init() {
@@ -16,35 +33,198 @@ bool init() {
     if (!Backend::create()) {
         return false;
     }
+    Startup::mark("backend created");
     if (!Renderer::create()) {
         return false;
     }
+    Startup::mark("renderer created");
+
+    auto &fonts = Backend::sharedFontAtlas();
+    fonts.AddFontDefault();
+#ifndef EMSCRIPTEN
+    const auto fontCache = FontAtlasCache::defaultPath();
+    if (FontAtlasCache::load(fonts, fontCache)) {
+        Startup::mark("font atlas loaded from cache");
+        return true;
+    }
+    fonts.Build();
+    FontAtlasCache::save(fonts, fontCache);
+#endif
+    Startup::mark("font atlas built");
     return true;
 }
 
+#ifndef EMSCRIPTEN
+// Stand-in for an acquisition process, publishing a moving sine into shared memory at 25 Hz
+int runSharedMemoryProducer(const char *name) {
+    constexpr int SIZE   = 100000;
+    auto          writer = SharedMemoryWriter::create(name, SIZE);
+    if (!writer) {
+        return 1;
+    }
+
+    std::vector<float> xs(SIZE), ys(SIZE);
+    for (double offset = 0;; offset += 0.1) {
+        for (int i = 0; i < SIZE; ++i) {
+            xs[i] = float(i) / 100.f;
+            ys[i] = std::sin(offset + xs[i]);
+        }
+        writer->write(0, xs, ys);
+        std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    }
+}
+
+// Thin viewer, drawing the frames of a process started with --remote-serve
+int runRemoteViewer(const char *path) {
+    if (!init()) {
+        return 1;
+    }
+    Window win(1000, 1000);
+    auto   client = RemoteClient::connect(win, path);
+    if (!client) {
+        return 1;
+    }
+    win.onRender = [&]() {
+        client->render();
+
+        const auto &stats = client->stats();
+        using Ms          = std::chrono::duration<double, std::milli>;
+        ImGui::Begin("Remote");
+        ImGui::Text("%s", client->isConnected() ? "Connected" : "Disconnected");
+        ImGui::Text("%llu frames, %.1f kB/s, %.1f:1 compression", (unsigned long long) stats.framesReceived, stats.bytesPerSecond / 1024.,
+                stats.receivedBytes ? double(stats.rawBytes) / double(stats.receivedBytes) : 0.);
+        ImGui::Text("Latency: %.2f ms, %.2f ms max", Ms(stats.latency).count(), Ms(stats.maxLatency).count());
+        ImGui::End();
+    };
+    win.show();
+    Backend::instance().run();
+    return 0;
+}
+#endif
+
 int main(int argc, char **argv) {
+#ifndef EMSCRIPTEN
+    // --shm-write <name>: run as producer, --shm <name>: plot the data of a producer
+    if (argc == 3 && std::string_view(argv[1]) == "--shm-write") {
+        return runSharedMemoryProducer(argv[2]);
+    }
+    // --remote-serve <socket>: stream the frames to viewers, --remote-view <socket>: show them
+    if (argc == 3 && std::string_view(argv[1]) == "--remote-view") {
+        return runRemoteViewer(argv[2]);
+    }
+#endif
+
     if (!init()) {
         return 1;
     }
 
     SinDataSet2D dataset;
+    Startup::mark("data sets created");
 
     Window     win(1000, 1000);
+    Startup::mark("window created");
 
     dataset.onDataChanged = [&](int, int) {
         win.scheduleRender();
     };
 
+    Plot::Heatmap heatmap(dataset, 2, 2000, 2000);
+    heatmap.setRange(-1, 1);
+
+#ifndef EMSCRIPTEN
+    std::unique_ptr<SharedMemoryDataSet> shmDataSet;
+    if (argc == 3 && std::string_view(argv[1]) == "--shm") {
+        shmDataSet = SharedMemoryDataSet::open(argv[2]);
+        if (shmDataSet) {
+            shmDataSet->onDataChanged = [&](int, int) {
+                win.scheduleRender();
+            };
+        }
+    }
+
+    // --replay <log> [speed]: plot a recorded data set log, a speed of 0 replays as fast as possible
+    std::unique_ptr<DataSetLog>      log;
+    std::unique_ptr<ReplayDataSet>   replayDataSet;
+    std::unique_ptr<DataSetReplayer> replayer;
+    if (argc >= 3 && std::string_view(argv[1]) == "--replay") {
+        log = DataSetLog::open(argv[2]);
+        if (log && log->dimension() >= 2) {
+            replayDataSet                = std::make_unique<ReplayDataSet>(log->dimension());
+            replayDataSet->onDataChanged = [&](int, int) {
+                win.scheduleRender();
+            };
+            replayer = std::make_unique<DataSetReplayer>(*log, [&](const DataSetLog::Record &record) { replayDataSet->apply(record); });
+            replayer->start(argc >= 4 ? std::atof(argv[3]) : 1.);
+        }
+    }
+
+    // running statistics of the live traces, over everything and the last 100000 points
+    std::unique_ptr<StreamStatistics> shmStatistics;
+    std::unique_ptr<StreamStatistics> replayStatistics;
+    if (shmDataSet) {
+        shmStatistics = std::make_unique<StreamStatistics>(*shmDataSet, 1, 100000);
+    }
+    if (replayDataSet) {
+        replayStatistics = std::make_unique<StreamStatistics>(*replayDataSet, 1, 100000);
+    }
+
+    std::unique_ptr<RemoteServer> remoteServer;
+    if (argc == 3 && std::string_view(argv[1]) == "--remote-serve") {
+        remoteServer = RemoteServer::listen(win, argv[2]);
+    }
+#endif
+
     win.onRender = [&]() {
         ImGui::SetNextWindowPos({ 0, 0 });
         const auto size = win.pixelSize();
         ImGui::SetNextWindowSize({ float(size.width), float(size.height) });
         ImGui::Begin("Main Window", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_NoBringToFrontOnFocus);
+        const auto &allocs = win.backendWindow().allocatorStats();
+        ImGui::Text("ImGui allocations: %llu per frame (%llu bytes), %llu bytes live", (unsigned long long) allocs.lastFrameAllocations,
+                (unsigned long long) allocs.lastFrameBytes, (unsigned long long) allocs.liveBytes);
+        ImGui::Text("DataSet memory: %.1f MB", dataset.memoryUsage() / (1024. * 1024.));
+        for (const auto &task : Backend::threadPool().stats()) {
+            using Ms = std::chrono::duration<double, std::milli>;
+            ImGui::Text("%s: %llu runs, %.2f ms average, %.2f ms max", task.name, (unsigned long long) task.count,
+                    Ms(task.total).count() / double(task.count), Ms(task.max).count());
+        }
+#ifndef EMSCRIPTEN
+        if (remoteServer) {
+            const auto &stats = remoteServer->stats();
+            ImGui::Text("Remote viewer %s: %llu frames sent, %llu skipped, %.1f:1 compression, %.2f ms encoding", remoteServer->isConnected() ? "connected" : "not connected",
+                    (unsigned long long) stats.framesSent, (unsigned long long) stats.framesSkipped,
+                    stats.sentBytes ? double(stats.rawBytes) / double(stats.sentBytes) : 0.,
+                    stats.framesSent ? std::chrono::duration<double, std::milli>(stats.encodeTime).count() / double(stats.framesSent) : 0.);
+        }
+        for (const auto *statistics : { shmStatistics.get(), replayStatistics.get() }) {
+            if (statistics) {
+                const auto &t = statistics->total();
+                const auto &w = statistics->window();
+                ImGui::Text("Trace: mean %.4g, RMS %.4g, min %.4g, max %.4g, p1 %.4g, p99 %.4g; last %lld points: mean %.4g, RMS %.4g", t.mean, t.rms, t.min,
+                        t.max, t.p1, t.p99, (long long) w.count, w.mean, w.rms);
+            }
+        }
+#endif
         if (ImPlot::BeginPlot("My Plot")) {
             // ImPlot::SetupAxis(ImAxis_X1, "My X-Axis", ImPlotAxisFlags_LogScale);
             // ImPlot::PlotLine("My Line Plot", dataset.getValues(0).data(), dataset.getValues(1).data(), dataset.getDataCount());
 
-            ImPlot::PlotHeatmap("Heightmap", dataset.getValues(2).data() ,2000,2000, -1, 1, nullptr);
+            if (dataset.isReady()) {
+                heatmap.plot("Heightmap");
+            } else {
+                ImPlot::PlotText("Loading...", 0.5, 0.5);
+            }
+
+#ifndef EMSCRIPTEN
+            if (shmDataSet) {
+                ImPlot::PlotLine("Shared memory", shmDataSet->getValues(0).data(), shmDataSet->getValues(1).data(), shmDataSet->getDataCount());
+                Plot::statistics("Shared memory statistics", *shmStatistics, true);
+            }
+            if (replayDataSet) {
+                ImPlot::PlotLine("Replay", replayDataSet->getValues(0).data(), replayDataSet->getValues(1).data(), replayDataSet->getDataCount());
+                Plot::statistics("Replay statistics", *replayStatistics, true);
+            }
+#endif
 
             ImPlot::EndPlot();
         }
@@ -55,6 +235,7 @@ int main(int argc, char **argv) {
         ImPlot::ShowDemoWindow();
     };
     win.show();
+    Startup::mark("window shown");
 
     Backend::instance().run();
 }
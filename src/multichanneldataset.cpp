@@ -0,0 +1,46 @@
+#include "multichanneldataset.h"
+
+#include <algorithm>
+
+namespace ImChart {
+
+MultiChannelDataSet::MultiChannelDataSet(int channels, int samples)
+    : m_channels(std::max(1, channels))
+    , m_samples(std::max(0, samples)) {
+    _xdata.resize(m_samples);
+    _ydata.resize(size_t(m_channels) * m_samples);
+}
+
+MultiChannelDataSet::~MultiChannelDataSet() {
+}
+
+float MultiChannelDataSet::get(int dimIndex, int index) const {
+    return dimIndex == 0 ? _xdata[index] : _ydata[size_t(dimIndex - 1) * m_samples + index];
+}
+
+std::span<float> MultiChannelDataSet::getValues(int dimIndex) {
+    return dimIndex == 0 ? xValues() : channel(dimIndex - 1);
+}
+
+size_t MultiChannelDataSet::memoryUsage() const {
+    return ImChart::memoryUsage(_xdata) + ImChart::memoryUsage(_ydata);
+}
+
+MultiChannelDataSet::ChannelMask MultiChannelDataSet::allChannels() const {
+    ChannelMask mask((m_channels + 63) / 64, ~uint64_t(0));
+    if (m_channels % 64) {
+        mask.back() = (uint64_t(1) << (m_channels % 64)) - 1;
+    }
+    return mask;
+}
+
+void MultiChannelDataSet::channelsChanged(int startIndex, int count, const ChannelMask &mask) {
+    m_changed = mask;
+    if (onChannelsChanged) {
+        onChannelsChanged(startIndex, count, mask);
+    }
+    dataChanged(startIndex, count);
+    m_changed.clear();
+}
+
+} // namespace ImChart
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "storage.h"
+#include <dataset.h>
+
+namespace ImChart {
+
+/**
+ * Many synchronized traces sharing one x axis, e.g. the channels of a digitizer.
+ *
+ * Dimension 0 holds the shared x values, dimension 1 + c the y values of channel c. The y values
+ * of all channels live in one channel-major block, so channel(c) is contiguous and the block is
+ * one allocation however many channels there are.
+ *
+ * Producers write into xValues() and channel(), then call channelsChanged() with the mask of the
+ * channels they touched. It calls onChannelsChanged and then the regular dataChanged(), during
+ * which changedChannels() holds the mask for listeners of the plain signal.
+ */
+class MultiChannelDataSet : public DataSet {
+public:
+    // Bit c % 64 of word c / 64 is set if channel c changed
+    using ChannelMask = std::vector<uint64_t>;
+
+    MultiChannelDataSet(int channels, int samples);
+    ~MultiChannelDataSet();
+
+    float                                               get(int dimIndex, int index) const final;
+    int                                                 getDataCount() const final { return m_samples; }
+    int                                                 getDimension() const final { return 1 + m_channels; }
+    std::span<float>                                    getValues(int dimIndex) final;
+
+    size_t                                              memoryUsage() const final;
+
+    int                                                 channels() const { return m_channels; }
+    std::span<float>                                    xValues() { return _xdata; }
+    std::span<float>                                    channel(int c) { return { _ydata.data() + size_t(c) * m_samples, size_t(m_samples) }; }
+
+    // A mask with all channels set
+    ChannelMask                                         allChannels() const;
+    const ChannelMask                                  &changedChannels() const { return m_changed; }
+
+    void                                                channelsChanged(int startIndex, int count, const ChannelMask &mask);
+
+    // signals:
+    std::function<void(int, int, const ChannelMask &)> onChannelsChanged;
+
+private:
+    int          m_channels;
+    int          m_samples;
+    ChannelMask  m_changed;
+    FloatStorage _xdata;
+    FloatStorage _ydata;
+};
+
+} // namespace ImChart
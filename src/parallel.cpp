@@ -0,0 +1,20 @@
+#include "parallel.h"
+
+#include "backends/backend.h"
+#include "threadpool.h"
+
+namespace ImChart {
+
+int parallelism() {
+    return Backend::threadPool().workerCount() + 1;
+}
+
+int parallelChunks(size_t count, size_t minChunk) {
+    return Backend::threadPool().chunkCount(count, minChunk);
+}
+
+void parallelFor(size_t count, size_t minChunk, const std::function<void(size_t begin, size_t end, int worker)> &fn, const char *name) {
+    Backend::threadPool().parallelFor(name, count, minChunk, fn);
+}
+
+} // namespace ImChart
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace ImChart {
+
+/**
+ * @return the maximum number of chunks parallelFor() splits the work in
+ */
+int  parallelism();
+
+/**
+ * @return the number of chunks parallelFor() splits [0, count) in, its 'worker' is below it
+ */
+int  parallelChunks(size_t count, size_t minChunk);
+
+/**
+ * Splits [0, count) in chunks of at least 'minChunk' elements and runs them in parallel on the
+ * thread pool of the backend, blocking until all are done. 'worker' is in [0, parallelism()) and
+ * unique among the chunks of one call, so it can be used to index per-worker scratch buffers.
+ * The run time is accounted under 'name' in the statistics of the pool.
+ */
+void parallelFor(size_t count, size_t minChunk, const std::function<void(size_t begin, size_t end, int worker)> &fn, const char *name = "parallelFor");
+
+} // namespace ImChart
@@ -0,0 +1,1133 @@
+#include "plotitems.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <optional>
+#include <shared_mutex>
+#include <vector>
+
+#include <implot.h>
+#include <implot_internal.h>
+
+#include "backends/backend.h"
+#include "dataset.h"
+#include "digitaldataset.h"
+#include "multichanneldataset.h"
+#include "parallel.h"
+#include "renderers/renderer.h"
+#include "spatialindex.h"
+#include "streamstatistics.h"
+#include "transform.h"
+#include "waterfalldataset.h"
+#include "window.h"
+
+namespace ImChart::Plot {
+
+namespace {
+
+// Scratch buffers reused from one frame to the next, plot items only run on the UI thread
+struct Envelope {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> low;
+    std::vector<float> high;
+
+    void               resize(size_t size) {
+        x.resize(size);
+        y.resize(size);
+        low.resize(size);
+        high.resize(size);
+    }
+    int size() const { return int(x.size()); }
+};
+
+Envelope g_envelope;
+Envelope g_line;
+Envelope g_channels;
+
+std::vector<int>   g_columnStart;
+std::vector<float> g_edgeX;
+
+// Transform of an axis of the current plot to pixels within the plot area, with y pointing down
+AxisTransform plotTransform(ImAxis axis) {
+    const auto  limits = ImPlot::GetPlotLimits();
+    const auto  size   = ImPlot::GetPlotSize();
+    const bool  isX    = axis == ImAxis_X1;
+    const auto  range  = isX ? limits.X : limits.Y;
+    const float extent = float(std::max(1, int(isX ? size.x : size.y)));
+    const float p0     = isX ? 0.f : extent;
+    const float p1     = isX ? extent : 0.f;
+    if (ImPlot::GetCurrentPlot()->Axes[axis].Flags & ImPlotAxisFlags_LogScale) {
+        return AxisTransform::log(float(range.Min), float(range.Max), p0, p1);
+    }
+    return AxisTransform::linear(float(range.Min), float(range.Max), p0, p1);
+}
+
+// Index range of the sorted values within [min, max], extended by one point on each side
+std::pair<int, int> visibleRange(std::span<const float> xs, float min, float max) {
+    const int start = std::max(0, int(std::lower_bound(xs.begin(), xs.end(), min) - xs.begin()) - 1);
+    const int end   = std::min(int(xs.size()), int(std::upper_bound(xs.begin(), xs.end(), max) - xs.begin()) + 1);
+    return { start, std::max(start, end) };
+}
+
+// Fills 'low'/'high' with y - negative error and y + positive error for the points [start, end)
+void computeErrorLimits(DataSet &dataSet, int start, int end, std::span<const float> ys, float *low, float *high) {
+    const auto noErrors = [&]() {
+        std::copy(ys.begin() + start, ys.begin() + end, low);
+        std::copy(ys.begin() + start, ys.begin() + end, high);
+    };
+    switch (dataSet.getErrorType(1)) {
+    case DataSet::ErrorType::None:
+        noErrors();
+        break;
+    case DataSet::ErrorType::PerPoint: {
+        const auto pos = dataSet.getPositiveErrors(1);
+        const auto neg = dataSet.getNegativeErrors(1);
+        // hasErrors is set, but the data set does not hold errors for these points
+        if (pos.size() < size_t(end) || neg.size() < size_t(end)) {
+            noErrors();
+            break;
+        }
+        for (int i = start; i < end; ++i) {
+            low[i - start]  = ys[i] - neg[i];
+            high[i - start] = ys[i] + pos[i];
+        }
+        break;
+    }
+    case DataSet::ErrorType::Uniform:
+    case DataSet::ErrorType::Segmented: {
+        const auto segments = dataSet.getErrorSegments(1);
+        auto       segment  = std::upper_bound(segments.begin(), segments.end(), start, [](int i, const DataSet::ErrorSegment &s) { return i < s.start; });
+        int        i        = start;
+        if (segment == segments.begin()) {
+            // no errors before the first segment
+            const int runEnd = segments.empty() ? end : std::min(end, segments.front().start);
+            for (; i < runEnd; ++i) {
+                low[i - start] = high[i - start] = ys[i];
+            }
+        } else {
+            --segment;
+        }
+        for (; i < end; ++segment) {
+            const auto next   = segment + 1;
+            const int  runEnd = next == segments.end() ? end : std::min(end, next->start);
+            const auto pos    = segment->positive;
+            const auto neg    = segment->negative;
+            for (; i < runEnd; ++i) {
+                low[i - start]  = ys[i] - neg;
+                high[i - start] = ys[i] + pos;
+            }
+        }
+        break;
+    }
+    }
+}
+
+// Computes the error limits of the visible points, merged into one min/max envelope per pixel column when there are more points than columns
+bool computeEnvelope(DataSet &dataSet, Envelope &env) {
+    const auto xs = dataSet.getValues(0);
+    const auto ys = dataSet.getValues(1);
+    if (xs.empty() || ys.size() < xs.size()) {
+        return false;
+    }
+
+    const auto xAxis        = plotTransform(ImAxis_X1);
+    // include one point outside the plot on each side, so bands reach the plot borders
+    const auto [start, end] = visibleRange(xs, xAxis.min(), xAxis.max());
+    const int  count        = end - start;
+    const int  width        = std::max(1, int(ImPlot::GetPlotSize().x));
+    if (count <= 0) {
+        env.resize(0);
+        return true;
+    }
+
+    if (count <= width) {
+        env.resize(count);
+        std::copy(xs.begin() + start, xs.begin() + end, env.x.begin());
+        std::copy(ys.begin() + start, ys.begin() + end, env.y.begin());
+        computeErrorLimits(dataSet, start, end, ys, env.low.data(), env.high.data());
+        return true;
+    }
+
+    // Dense case, compute the limits of the visible points in chunks and fold them into the pixel columns
+    constexpr int CHUNK = 4096;
+    float         low[CHUNK];
+    float         high[CHUNK];
+    float         px[CHUNK];
+
+    auto         &colLow  = env.low;
+    auto         &colHigh = env.high;
+    colLow.assign(width, std::numeric_limits<float>::max());
+    colHigh.assign(width, std::numeric_limits<float>::lowest());
+    for (int chunk = start; chunk < end; chunk += CHUNK) {
+        const int chunkEnd = std::min(end, chunk + CHUNK);
+        computeErrorLimits(dataSet, chunk, chunkEnd, ys, low, high);
+        xAxis.toPixels(xs.data() + chunk, chunkEnd - chunk, px);
+        for (int i = 0; i < chunkEnd - chunk; ++i) {
+            const int col = std::clamp(int(px[i]), 0, width - 1);
+            colLow[col]   = std::min(colLow[col], low[i]);
+            colHigh[col]  = std::max(colHigh[col], high[i]);
+        }
+    }
+
+    // drop the empty columns
+    env.x.resize(width);
+    env.y.resize(width);
+    int n = 0;
+    for (int col = 0; col < width; ++col) {
+        if (colLow[col] > colHigh[col]) {
+            continue;
+        }
+        env.x[n]    = xAxis.fromPixel(col + 0.5f);
+        env.low[n]  = colLow[col];
+        env.high[n] = colHigh[col];
+        env.y[n]    = 0.5f * (colLow[col] + colHigh[col]);
+        ++n;
+    }
+    env.resize(n);
+    return true;
+}
+
+// Samples the current ImPlot colormap into a 256 entry RGBA8 table
+void sampleColormap(std::vector<uint32_t> &lut) {
+    lut.resize(256);
+    for (int i = 0; i < 256; ++i) {
+        lut[i] = ImGui::ColorConvertFloat4ToU32(ImPlot::SampleColormap(i / 255.f));
+    }
+}
+
+// Number of points to visit between two checks for cancellation when computing line points
+constexpr int CANCEL_CHECK_INTERVAL = 1 << 18;
+
+// First and last x value and point count of a segment, from its summary when the data set keeps one,
+// so segments of compressed data sets are not decoded just to be skipped. False if it is empty.
+bool segmentBounds(DataSet &dataSet, int segment, float &first, float &last, int &count) {
+    if (const auto summary = dataSet.getSegmentSummary(0, segment)) {
+        first = summary->min;
+        last  = summary->max;
+        count = summary->count;
+    } else {
+        const auto xs = dataSet.getSegment(0, segment);
+        count         = int(xs.size());
+        if (count > 0) {
+            first = xs.front();
+            last  = xs.back();
+        }
+    }
+    return count > 0;
+}
+
+// Number of points within [xmin, xmax] over all segments, see visibleRange()
+size_t visibleCount(DataSet &dataSet, float xmin, float xmax) {
+    size_t visible = 0;
+    for (int s = 0;; ++s) {
+        // the segments are read from the thread pool as well, while the data set may grow
+        std::shared_lock lock(dataSet.storageLock());
+        if (s >= dataSet.getSegmentCount()) {
+            break;
+        }
+        float first, last;
+        int   count;
+        if (!segmentBounds(dataSet, s, first, last, count) || last < xmin || first > xmax) {
+            continue;
+        }
+        if (first >= xmin && last <= xmax) {
+            visible += count;
+            continue;
+        }
+        const auto [start, end] = visibleRange(dataSet.getSegment(0, s), xmin, xmax);
+        visible += end - start;
+    }
+    return visible;
+}
+
+/**
+ * Computes the points of a line through the data within the range of 'xAxis' into 'out.x'/'out.y'.
+ * If there are more than two points per pixel column, the line goes through the min and max of each
+ * column instead, computed from every stride-th point. Returns false if cancelled() returned true,
+ * which is checked regularly while folding.
+ */
+template<typename Cancelled>
+bool linePoints(DataSet &dataSet, const AxisTransform &xAxis, int width, int stride, Envelope &out, Cancelled cancelled) {
+    const float xmin = xAxis.min();
+    const float xmax = xAxis.max();
+    out.x.clear();
+    out.y.clear();
+    if (visibleCount(dataSet, xmin, xmax) <= size_t(2 * width)) {
+        // sparse, collect the points so the line continues across segment boundaries
+        for (int s = 0;; ++s) {
+            std::shared_lock lock(dataSet.storageLock());
+            if (s >= dataSet.getSegmentCount()) {
+                break;
+            }
+            float first, last;
+            int   count;
+            if (!segmentBounds(dataSet, s, first, last, count) || last < xmin || first > xmax) {
+                continue;
+            }
+            const auto xs           = dataSet.getSegment(0, s);
+            const auto ys           = dataSet.getSegment(1, s);
+            const auto [start, end] = visibleRange(xs, xmin, xmax);
+            out.x.insert(out.x.end(), xs.begin() + start, xs.begin() + end);
+            out.y.insert(out.y.end(), ys.begin() + start, ys.begin() + end);
+        }
+        return true;
+    }
+
+    // the points are gathered and transformed to pixels in blocks, so the transform vectorizes
+    constexpr int BLOCK = 256;
+    float         px[BLOCK];
+    float         py[BLOCK];
+
+    auto         &colLow  = out.low;
+    auto         &colHigh = out.high;
+    colLow.assign(width, std::numeric_limits<float>::max());
+    colHigh.assign(width, std::numeric_limits<float>::lowest());
+    const auto column  = [&](float x) { return std::clamp(int(xAxis.toPixel(x)), 0, width - 1); };
+    int        visited = 0;
+    for (int s = 0;; ++s) {
+        std::shared_lock lock(dataSet.storageLock());
+        if (s >= dataSet.getSegmentCount()) {
+            break;
+        }
+        float first, last;
+        int   count;
+        if (!segmentBounds(dataSet, s, first, last, count) || last < xmin || first > xmax) {
+            continue;
+        }
+        const auto summary = dataSet.getSegmentSummary(1, s);
+        if (summary && first >= xmin && last <= xmax && column(first) == column(last)) {
+            const int col = column(first);
+            colLow[col]   = std::min(colLow[col], summary->min);
+            colHigh[col]  = std::max(colHigh[col], summary->max);
+            continue;
+        }
+        const auto xs           = dataSet.getSegment(0, s);
+        const auto ys           = dataSet.getSegment(1, s);
+        const auto [start, end] = visibleRange(xs, xmin, xmax);
+        for (int i = start; i < end;) {
+            int n = 0;
+            for (; n < BLOCK && i < end; ++n, i += stride) {
+                px[n] = xs[i];
+                py[n] = ys[i];
+            }
+            xAxis.toPixels(px, n, px);
+            for (int j = 0; j < n; ++j) {
+                const int col = std::clamp(int(px[j]), 0, width - 1);
+                colLow[col]   = std::min(colLow[col], py[j]);
+                colHigh[col]  = std::max(colHigh[col], py[j]);
+            }
+            visited += n;
+            if (visited >= CANCEL_CHECK_INTERVAL) {
+                if (cancelled()) {
+                    return false;
+                }
+                visited = 0;
+            }
+        }
+    }
+
+    for (int col = 0; col < width; ++col) {
+        if (colLow[col] > colHigh[col]) {
+            continue;
+        }
+        const float x = xAxis.fromPixel(col + 0.5f);
+        out.x.push_back(x);
+        out.y.push_back(colLow[col]);
+        out.x.push_back(x);
+        out.y.push_back(colHigh[col]);
+    }
+    return true;
+}
+
+// The x range covered by the data set, nullopt if it is empty
+std::optional<std::pair<float, float>> dataRange(DataSet &dataSet) {
+    std::optional<std::pair<float, float>> range;
+    for (int s = 0;; ++s) {
+        std::shared_lock lock(dataSet.storageLock());
+        if (s >= dataSet.getSegmentCount()) {
+            break;
+        }
+        float first, last;
+        int   count;
+        if (!segmentBounds(dataSet, s, first, last, count)) {
+            continue;
+        }
+        if (!range) {
+            range = std::make_pair(first, last);
+        }
+        range->second = last;
+    }
+    return range;
+}
+
+} // namespace
+
+void line(const char *label, DataSet &dataSet) {
+    const int width = std::max(1, int(ImPlot::GetPlotSize().x));
+    linePoints(dataSet, plotTransform(ImAxis_X1), width, 1, g_line, [] { return false; });
+    ImPlot::PlotLine(label, g_line.x.data(), g_line.y.data(), g_line.size());
+}
+
+int hoveredPoint(SpatialIndex &index, float maxPixels) {
+    if (!ImPlot::IsPlotHovered()) {
+        return -1;
+    }
+    const auto pos   = ImPlot::GetPlotPos();
+    const auto mouse = ImGui::GetIO().MousePos;
+    return index.nearest(plotTransform(ImAxis_X1), plotTransform(ImAxis_Y1), mouse.x - pos.x, mouse.y - pos.y, maxPixels);
+}
+
+void channels(const char *label, MultiChannelDataSet &dataSet, float spacing) {
+    ImPlot::PlotDummy(label);
+
+    const auto xAxis        = plotTransform(ImAxis_X1);
+    const auto yAxis        = plotTransform(ImAxis_Y1);
+    const auto pos          = ImPlot::GetPlotPos();
+    const int  width        = std::max(1, int(ImPlot::GetPlotSize().x));
+    const auto xs           = dataSet.xValues();
+    const auto [start, end] = visibleRange(xs, xAxis.min(), xAxis.max());
+    const int  count        = end - start;
+    if (count < 2) {
+        return;
+    }
+
+    // pixel columns of the visible samples, shared by all channels
+    auto &buf = g_channels;
+    buf.x.resize(count);
+    xAxis.toPixels(xs.data() + start, count, buf.x.data());
+    const bool dense = count > 2 * width;
+    if (dense) {
+        // the samples of column col are [g_columnStart[col], g_columnStart[col + 1])
+        g_columnStart.assign(width + 1, count);
+        for (int i = count - 1; i >= 0; --i) {
+            g_columnStart[std::clamp(int(buf.x[i]), 0, width - 1)] = i;
+        }
+        for (int col = width - 1; col >= 0; --col) {
+            g_columnStart[col] = std::min(g_columnStart[col], g_columnStart[col + 1]);
+        }
+    }
+
+    auto      *drawList = ImPlot::GetPlotDrawList();
+    const auto uv       = ImGui::GetFontTexUvWhitePixel();
+    ImPlot::PushPlotClipRect();
+    for (int c = 0; c < dataSet.channels(); ++c) {
+        const auto  ys     = dataSet.channel(c).subspan(start, count);
+        const float offset = c * spacing;
+        auto       &vx     = buf.low;
+        auto       &vy     = buf.high;
+        vx.clear();
+        vy.clear();
+        if (dense) {
+            for (int col = 0; col < width; ++col) {
+                const int b = g_columnStart[col];
+                const int e = g_columnStart[col + 1];
+                if (b == e) {
+                    continue;
+                }
+                float lo = ys[b];
+                float hi = ys[b];
+                for (int i = b + 1; i < e; ++i) {
+                    lo = std::min(lo, ys[i]);
+                    hi = std::max(hi, ys[i]);
+                }
+                vx.insert(vx.end(), 2, col + 0.5f);
+                vy.push_back(lo + offset);
+                vy.push_back(hi + offset);
+            }
+        } else {
+            vx.assign(buf.x.begin(), buf.x.end());
+            vy.resize(count);
+            for (int i = 0; i < count; ++i) {
+                vy[i] = ys[i] + offset;
+            }
+        }
+        const int n = int(vy.size());
+        yAxis.toPixels(vy.data(), n, vy.data());
+        if (n < 2) {
+            continue;
+        }
+
+        // one pixel wide quad per segment
+        const ImU32 color = ImGui::ColorConvertFloat4ToU32(ImPlot::GetColormapColor(c));
+        drawList->PrimReserve(6 * (n - 1), 4 * (n - 1));
+        for (int i = 1; i < n; ++i) {
+            const ImVec2 a(pos.x + vx[i - 1], pos.y + vy[i - 1]);
+            const ImVec2 b(pos.x + vx[i], pos.y + vy[i]);
+            float        dx  = b.x - a.x;
+            float        dy  = b.y - a.y;
+            const float  len = std::sqrt(dx * dx + dy * dy);
+            if (len > 0) {
+                dx /= len;
+                dy /= len;
+            } else {
+                dx = 1;
+            }
+            const ImVec2 normal(-dy * 0.5f, dx * 0.5f);
+            drawList->PrimQuadUV({ a.x + normal.x, a.y + normal.y }, { b.x + normal.x, b.y + normal.y }, { b.x - normal.x, b.y - normal.y },
+                    { a.x - normal.x, a.y - normal.y }, uv, uv, uv, uv, color);
+        }
+    }
+    ImPlot::PopPlotClipRect();
+}
+
+void digital(const char *label, DigitalDataSet &dataSet, float height, float spacing) {
+    ImPlot::PlotDummy(label);
+
+    const int samples = dataSet.getDataCount();
+    if (samples == 0) {
+        return;
+    }
+    const auto  xAxis  = plotTransform(ImAxis_X1);
+    const auto  yAxis  = plotTransform(ImAxis_Y1);
+    const auto  pos    = ImPlot::GetPlotPos();
+    const float x0     = dataSet.x0();
+    const float dt     = dataSet.dt();
+    const int   first  = std::clamp(int(std::floor((xAxis.min() - x0) / dt)), 0, samples - 1);
+    const int   last   = std::clamp(int(std::ceil((xAxis.max() - x0) / dt)), 0, samples - 1);
+    const float xFirst = pos.x + xAxis.toPixel(x0 + first * dt);
+    const float xLast  = pos.x + xAxis.toPixel(x0 + last * dt);
+
+    auto *drawList = ImPlot::GetPlotDrawList();
+    ImPlot::PushPlotClipRect();
+    for (int c = 0; c < dataSet.channels(); ++c) {
+        const auto &edges = dataSet.edges(c);
+        const auto  lo    = std::upper_bound(edges.begin(), edges.end(), first);
+        const auto  hi    = std::upper_bound(lo, edges.end(), last);
+        const int   n     = int(hi - lo);
+        g_edgeX.resize(n);
+        for (int i = 0; i < n; ++i) {
+            g_edgeX[i] = x0 + lo[i] * dt;
+        }
+        xAxis.toPixels(g_edgeX.data(), n, g_edgeX.data());
+
+        const float yLow  = pos.y + yAxis.toPixel(c * spacing);
+        const float yHigh = pos.y + yAxis.toPixel(c * spacing + height);
+        const ImU32 color = ImGui::ColorConvertFloat4ToU32(ImPlot::GetColormapColor(c));
+        bool        level = dataSet.bit(c, first);
+        float       x     = xFirst;
+        for (int i = 0; i < n;) {
+            // a run of edges with less than a pixel between them becomes one block
+            int j = i;
+            while (j + 1 < n && g_edgeX[j + 1] - g_edgeX[j] < 1.f) {
+                ++j;
+            }
+            const float start = pos.x + g_edgeX[i];
+            const float end   = pos.x + g_edgeX[j];
+            drawList->AddLine({ x, level ? yHigh : yLow }, { start, level ? yHigh : yLow }, color);
+            if (i == j) {
+                drawList->AddLine({ start, yHigh }, { start, yLow }, color);
+            } else {
+                drawList->AddRectFilled({ start, yHigh }, { std::max(end, start + 1.f), yLow }, color);
+            }
+            level = level ^ ((j - i + 1) & 1);
+            x     = end;
+            i     = j + 1;
+        }
+        drawList->AddLine({ x, level ? yHigh : yLow }, { xLast, level ? yHigh : yLow }, color);
+    }
+    ImPlot::PopPlotClipRect();
+}
+
+void errorBars(const char *label, DataSet &dataSet) {
+    auto &env = g_envelope;
+    if (!computeEnvelope(dataSet, env)) {
+        return;
+    }
+
+    // ImPlot wants the errors relative to the y value
+    for (int i = 0; i < env.size(); ++i) {
+        env.low[i]  = env.y[i] - env.low[i];
+        env.high[i] = env.high[i] - env.y[i];
+    }
+    ImPlot::PlotErrorBars(label, env.x.data(), env.y.data(), env.low.data(), env.high.data(), env.size());
+}
+
+void errorBand(const char *label, DataSet &dataSet) {
+    auto &env = g_envelope;
+    if (!computeEnvelope(dataSet, env)) {
+        return;
+    }
+    ImPlot::PlotShaded(label, env.x.data(), env.low.data(), env.high.data(), env.size());
+}
+
+void statistics(const char *label, const StreamStatistics &statistics, bool window) {
+    ImPlot::PlotDummy(label);
+    const auto &s = window ? statistics.window() : statistics.total();
+    if (s.count == 0) {
+        return;
+    }
+    const auto  yAxis = plotTransform(ImAxis_Y1);
+    const auto  pos   = ImPlot::GetPlotPos();
+    const auto  size  = ImPlot::GetPlotSize();
+    const float left  = pos.x;
+    const float right = pos.x + size.x;
+    const ImU32 color = ImGui::ColorConvertFloat4ToU32(ImPlot::GetLastItemColor());
+    const ImU32 fill  = (color & ~IM_COL32_A_MASK) | IM_COL32(0, 0, 0, 40);
+    const ImU32 faint = (color & ~IM_COL32_A_MASK) | IM_COL32(0, 0, 0, 120);
+    const auto  y     = [&](double value) { return pos.y + yAxis.toPixel(float(value)); };
+
+    auto *drawList = ImPlot::GetPlotDrawList();
+    ImPlot::PushPlotClipRect();
+    drawList->AddRectFilled({ left, y(s.p99) }, { right, y(s.p1) }, fill);
+    drawList->AddLine({ left, y(s.min) }, { right, y(s.min) }, faint);
+    drawList->AddLine({ left, y(s.max) }, { right, y(s.max) }, faint);
+    drawList->AddLine({ left, y(s.mean) }, { right, y(s.mean) }, color, 1.5f);
+
+    // the labels of the outer lines go outside, those of p1/p99 inside the band, so close lines don't overlap
+    const auto annotate = [&](double value, const char *name, bool below) {
+        char text[48];
+        snprintf(text, sizeof(text), "%s %.4g", name, value);
+        const ImVec2 textSize = ImGui::CalcTextSize(text);
+        drawList->AddText({ right - textSize.x - 4, below ? y(value) : y(value) - textSize.y }, color, text);
+    };
+    annotate(s.mean, "mean", false);
+    annotate(s.p1, "p1", false);
+    annotate(s.p99, "p99", true);
+    annotate(s.min, "min", true);
+    annotate(s.max, "max", false);
+    ImPlot::PopPlotClipRect();
+}
+
+Waterfall::Waterfall(WaterfallDataSet &dataSet)
+    : m_dataSet(dataSet) {
+}
+
+Waterfall::~Waterfall() {
+}
+
+void Waterfall::setRange(float min, float max) {
+    m_min          = min;
+    m_max          = max;
+    // the texture needs to be remapped
+    m_uploadedRows = 0;
+}
+
+void Waterfall::uploadRows() {
+    const int width = m_dataSet.width();
+    const int depth = m_dataSet.depth();
+    if (!m_texture) {
+        m_texture = Renderer::instance().createTexture();
+        m_texture->resize(width, depth);
+    }
+    if (m_lut.empty()) {
+        sampleColormap(m_lut);
+    }
+
+    const uint64_t written = m_dataSet.rowsWritten();
+    const uint64_t first   = std::max(m_uploadedRows, written > uint64_t(depth) ? written - depth : 0);
+    const float    scale   = 255.f / (m_max - m_min);
+    const auto     z       = m_dataSet.getValues(2);
+    m_row.resize(width);
+    for (uint64_t seq = first; seq < written; ++seq) {
+        const int    r   = int(seq % depth);
+        const float *src = z.data() + size_t(r) * width;
+        for (int i = 0; i < width; ++i) {
+            const float t = std::clamp((src[i] - m_min) * scale, 0.f, 255.f);
+            m_row[i]      = m_lut[int(t)];
+        }
+        m_texture->update(0, r, width, 1, m_row.data());
+    }
+    m_uploadedRows = written;
+}
+
+void Waterfall::plot(const char *label) {
+    uploadRows();
+
+    const uint64_t written = m_dataSet.rowsWritten();
+    const int      depth   = m_dataSet.depth();
+    const auto     xs      = m_dataSet.getValues(0);
+    const double   x0      = xs.front();
+    const double   x1      = xs.back();
+    const auto     tex     = m_texture->imguiTextureId();
+    const float    dv      = 1.f / depth;
+
+    // Texture row r is shown at the height of its age, newest at the top (y = depth). uv0 is drawn
+    // at the top of an image, so v runs from the newest row down to older ones. Where a quad ends
+    // within the texture, its v stops at the center of its last row, as linear filtering would
+    // blend in the row beyond it, the oldest one next to the newest.
+    const float half = dv / 2;
+    if (written < uint64_t(depth)) {
+        const int rows = int(written);
+        ImPlot::PlotImage(label, tex, { x0, double(depth - rows) }, { x1, double(depth) }, { 0, rows * dv - half }, { 1, 0 });
+        return;
+    }
+    const int head = int((written - 1) % depth);
+    // oldest part of the ring, the rows after the newest one
+    ImPlot::PlotImage(label, tex, { x0, 0 }, { x1, double(depth - head - 1) }, { 0, 1 }, { 1, (head + 1) * dv + half });
+    ImPlot::PlotImage(label, tex, { x0, double(depth - head - 1) }, { x1, double(depth) }, { 0, (head + 1) * dv - half }, { 1, 0 });
+}
+
+Heatmap::Heatmap(DataSet &dataSet, int dimIndex, int columns, int rows)
+    : m_dataSet(dataSet)
+    , m_dimIndex(dimIndex)
+    , m_columns(std::max(1, columns))
+    , m_rows(std::max(1, rows))
+    , m_dirtyLast(m_rows) {
+    m_listenerId = m_dataSet.addDataChangedListener([this](int start, int count) { dataChanged(start, count); });
+}
+
+Heatmap::~Heatmap() {
+    m_dataSet.removeDataChangedListener(m_listenerId);
+}
+
+void Heatmap::setRange(float min, float max) {
+    if (min == m_min && max == m_max) {
+        return;
+    }
+    m_min = min;
+    m_max = max;
+    // the texture needs to be remapped
+    dataChanged(0, 0);
+}
+
+void Heatmap::dataChanged(int start, int count) {
+    // an empty range, e.g. from clearing the data set, invalidates all rows
+    const int first = count > 0 ? std::clamp(start / m_columns, 0, m_rows) : 0;
+    const int last  = count > 0 ? std::clamp(int((int64_t(start) + count + m_columns - 1) / m_columns), 0, m_rows) : m_rows;
+    if (first >= last) {
+        return;
+    }
+    if (m_dirtyFirst >= m_dirtyLast) {
+        m_dirtyFirst = first;
+        m_dirtyLast  = last;
+    } else {
+        m_dirtyFirst = std::min(m_dirtyFirst, first);
+        m_dirtyLast  = std::max(m_dirtyLast, last);
+    }
+}
+
+bool Heatmap::mapRows(int first, int last) {
+    // Cells normalized at once, into a buffer of LUT indices small enough for the stack
+    constexpr int BLOCK     = 256;
+    // Fewer cells are not worth spreading over several threads
+    constexpr int MIN_CELLS = 1 << 16;
+
+    const auto values = m_dataSet.getValues(m_dimIndex);
+    if (values.size() < size_t(m_columns) * m_rows) {
+        return false;
+    }
+    const float     min       = m_min;
+    const float     scale     = m_max > m_min ? float(m_lut.size() - 1) / (m_max - m_min) : 0.f;
+    const float     lastEntry = float(m_lut.size() - 1);
+    const uint32_t *lut       = m_lut.data();
+    const size_t    columns   = size_t(m_columns);
+
+    parallelFor(last - first, std::max(1, MIN_CELLS / m_columns), [&](size_t begin, size_t end, int) {
+        int32_t index[BLOCK];
+        for (size_t r = first + begin; r < first + end; ++r) {
+            const float *src = values.data() + r * columns;
+            uint32_t    *dst = m_pixels.data() + r * columns;
+            for (size_t c = 0; c < columns; c += BLOCK) {
+                const int n = int(std::min<size_t>(BLOCK, columns - c));
+                for (int i = 0; i < n; ++i) {
+                    // a NaN fails the comparison and takes the first entry
+                    const float t = (src[c + i] - min) * scale;
+                    index[i]      = int32_t(std::min(t > 0.f ? t : 0.f, lastEntry));
+                }
+                for (int i = 0; i < n; ++i) {
+                    dst[c + i] = lut[index[i]];
+                }
+            }
+        }
+    }, "heatmap colormap");
+    return true;
+}
+
+void Heatmap::plot(const char *label, double x0, double y0, double x1, double y1) {
+    if (!m_texture) {
+        m_texture = Renderer::instance().createTexture();
+        m_texture->resize(m_columns, m_rows);
+    }
+    if (m_lut.empty()) {
+        sampleColormap(m_lut);
+    }
+    if (m_dirtyFirst < m_dirtyLast) {
+        m_pixels.resize(size_t(m_columns) * m_rows);
+        if (mapRows(m_dirtyFirst, m_dirtyLast)) {
+            m_texture->update(0, m_dirtyFirst, m_columns, m_dirtyLast - m_dirtyFirst, m_pixels.data() + size_t(m_dirtyFirst) * m_columns);
+            m_dirtyFirst = 0;
+            m_dirtyLast  = 0;
+        }
+    }
+    // texture row 0 is v = 0, which is drawn at the top of the image quad, like the first row of ImPlot::PlotHeatmap()
+    ImPlot::PlotImage(label, m_texture->imguiTextureId(), { x0, y0 }, { x1, y1 });
+}
+
+DensityScatter::DensityScatter(DataSet &dataSet)
+    : m_dataSet(dataSet) {
+    m_listenerId = m_dataSet.addDataChangedListener([this](int, int) { m_dirty = true; });
+}
+
+DensityScatter::~DensityScatter() {
+    m_dataSet.removeDataChangedListener(m_listenerId);
+}
+
+void DensityScatter::accumulate() {
+    // Points are transformed in blocks, so the pixel computation runs over contiguous arrays and vectorizes
+    constexpr int BLOCK     = 256;
+    // Fewer points are not worth spreading over several threads
+    constexpr int MIN_CHUNK = 1 << 16;
+
+    const int     width     = m_width;
+    const int     height    = m_height;
+    const size_t  cells     = size_t(width) * height;
+
+    // split a single array by points, several segments by segment, with a count buffer per chunk
+    const int     segments  = m_dataSet.getSegmentCount();
+    const size_t  points    = segments == 1 ? std::min(m_dataSet.getValues(0).size(), m_dataSet.getValues(1).size()) : 0;
+    const int     chunks    = segments == 1 ? parallelChunks(points, MIN_CHUNK) : parallelChunks(segments, 1);
+    m_partials.resize(chunks);
+    for (auto &p : m_partials) {
+        p.assign(cells + 1, 0); // the last cell collects the points outside of the view
+    }
+
+    const auto count = [&](std::span<const float> xs, std::span<const float> ys, size_t begin, size_t end, uint32_t *partial) {
+        float   px[BLOCK];
+        float   py[BLOCK];
+        int32_t cell[BLOCK];
+        for (size_t i = begin; i < end; i += BLOCK) {
+            const int n = int(std::min<size_t>(BLOCK, end - i));
+            // the y transform maps the top of the plot to texture row 0
+            m_x.toPixels(xs.data() + i, n, px);
+            m_y.toPixels(ys.data() + i, n, py);
+            for (int j = 0; j < n; ++j) {
+                const bool inside = (px[j] >= 0) & (px[j] < width) & (py[j] >= 0) & (py[j] < height);
+                cell[j]           = inside ? int32_t(py[j]) * width + int32_t(px[j]) : int32_t(cells);
+            }
+            for (int j = 0; j < n; ++j) {
+                ++partial[cell[j]];
+            }
+        }
+    };
+
+    if (segments == 1) {
+        const auto xs = m_dataSet.getValues(0);
+        const auto ys = m_dataSet.getValues(1);
+        parallelFor(points, MIN_CHUNK, [&](size_t begin, size_t end, int worker) {
+            count(xs, ys, begin, end, m_partials[worker].data());
+        }, "density scatter");
+    } else {
+        parallelFor(segments, 1, [&](size_t begin, size_t end, int worker) {
+            for (size_t s = begin; s < end; ++s) {
+                std::shared_lock lock(m_dataSet.storageLock());
+                const auto       xs = m_dataSet.getSegment(0, int(s));
+                const auto       ys = m_dataSet.getSegment(1, int(s));
+                count(xs, ys, 0, std::min(xs.size(), ys.size()), m_partials[worker].data());
+            }
+        }, "density scatter");
+    }
+
+    // merge the partial counts into the first buffer
+    auto &counts = m_partials.front();
+    if (chunks > 1) {
+        parallelFor(cells, MIN_CHUNK, [&](size_t begin, size_t end, int) {
+            for (size_t p = 1; p < m_partials.size(); ++p) {
+                const auto *partial = m_partials[p].data();
+                for (size_t i = begin; i < end; ++i) {
+                    counts[i] += partial[i];
+                }
+            }
+        }, "density scatter merge");
+    }
+
+    // log scale, empty pixels stay transparent
+    if (m_lut.empty()) {
+        sampleColormap(m_lut);
+    }
+    const uint32_t max   = *std::max_element(counts.begin(), counts.end() - 1);
+    const float    scale = max > 0 ? 255.f / std::log1p(float(max)) : 0.f;
+    m_pixels.resize(cells);
+    for (size_t i = 0; i < cells; ++i) {
+        m_pixels[i] = counts[i] ? m_lut[int(std::log1p(float(counts[i])) * scale)] : 0;
+    }
+
+    if (!m_texture) {
+        m_texture = Renderer::instance().createTexture();
+    }
+    if (m_texture->size().width != width || m_texture->size().height != height) {
+        m_texture->resize(width, height);
+    }
+    m_texture->update(0, 0, width, height, m_pixels.data());
+}
+
+void DensityScatter::plot(const char *label) {
+    const auto size   = ImPlot::GetPlotSize();
+    const auto x      = plotTransform(ImAxis_X1);
+    const auto y      = plotTransform(ImAxis_Y1);
+    const int  width  = std::max(1, int(size.x));
+    const int  height = std::max(1, int(size.y));
+
+    if (m_dirty || x != m_x || y != m_y || width != m_width || height != m_height) {
+        m_x      = x;
+        m_y      = y;
+        m_width  = width;
+        m_height = height;
+        m_dirty  = false;
+        accumulate();
+    }
+    ImPlot::PlotImage(label, m_texture->imguiTextureId(), { m_x.min(), m_y.min() }, { m_x.max(), m_y.max() });
+}
+
+Persistence::Persistence(DataSet &dataSet, Window &window)
+    : m_dataSet(dataSet)
+    , m_window(window) {
+    m_listenerId = m_dataSet.addDataChangedListener([this](int, int) { rasterize(); });
+}
+
+Persistence::~Persistence() {
+    m_dataSet.removeDataChangedListener(m_listenerId);
+}
+
+void Persistence::rasterize() {
+    // nothing to draw into before the first frame
+    if (m_intensity.empty()) {
+        return;
+    }
+    const auto xs    = m_dataSet.getValues(0);
+    const auto ys    = m_dataSet.getValues(1);
+    const int  count = int(std::min(xs.size(), ys.size()));
+    if (count == 0) {
+        return;
+    }
+
+    // to pixel coordinates, with row 0 at the top of the plot
+    m_px.resize(count);
+    m_py.resize(count);
+    m_x.toPixels(xs.data(), count, m_px.data());
+    m_y.toPixels(ys.data(), count, m_py.data());
+
+    const auto plotPixel = [&](float x, float y) {
+        if (x >= 0 && x < m_width && y >= 0 && y < m_height) {
+            m_intensity[size_t(y) * m_width + size_t(x)] = 1.f;
+        }
+    };
+    plotPixel(m_px[0], m_py[0]);
+    for (int i = 1; i < count; ++i) {
+        const float x0 = m_px[i - 1];
+        const float y0 = m_py[i - 1];
+        const float dx = m_px[i] - x0;
+        const float dy = m_py[i] - y0;
+        // skip segments entirely outside of the plot
+        if ((x0 < 0 && m_px[i] < 0) || (x0 >= m_width && m_px[i] >= m_width) || (y0 < 0 && m_py[i] < 0) || (y0 >= m_height && m_py[i] >= m_height)) {
+            continue;
+        }
+        const int steps = std::min(int(std::ceil(std::max(std::abs(dx), std::abs(dy)))), m_width + m_height);
+        for (int s = 1; s <= steps; ++s) {
+            plotPixel(x0 + dx * s / steps, y0 + dy * s / steps);
+        }
+    }
+    m_peak = 1.f;
+    m_window.scheduleRender();
+}
+
+void Persistence::decay() {
+    const auto now     = std::chrono::steady_clock::now();
+    const auto elapsed = std::chrono::duration<float>(now - m_lastDecay);
+    m_lastDecay        = now;
+    if (m_peak == 0) {
+        return;
+    }
+
+    const float factor = std::pow(0.01f, elapsed / m_decayTime);
+    // once below the lowest colormap entry the buffer is invisible, clear it and stop fading
+    const float cutoff = 1.f / 255.f;
+    m_peak *= factor;
+    if (m_peak < cutoff) {
+        std::fill(m_intensity.begin(), m_intensity.end(), 0.f);
+        m_peak = 0;
+        return;
+    }
+    for (auto &v : m_intensity) {
+        v *= factor;
+    }
+}
+
+void Persistence::plot(const char *label) {
+    const auto size   = ImPlot::GetPlotSize();
+    const auto x      = plotTransform(ImAxis_X1);
+    const auto y      = plotTransform(ImAxis_Y1);
+    const int  width  = std::max(1, int(size.x));
+    const int  height = std::max(1, int(size.y));
+
+    if (x != m_x || y != m_y || width != m_width || height != m_height) {
+        // the history is in pixel coordinates of the old view, start over with the current trace
+        m_x      = x;
+        m_y      = y;
+        m_width  = width;
+        m_height = height;
+        m_intensity.assign(size_t(width) * height, 0.f);
+        m_lastDecay = std::chrono::steady_clock::now();
+        rasterize();
+    } else {
+        decay();
+    }
+
+    if (m_lut.empty()) {
+        sampleColormap(m_lut);
+    }
+    m_pixels.resize(m_intensity.size());
+    for (size_t i = 0; i < m_intensity.size(); ++i) {
+        const float v = m_intensity[i];
+        m_pixels[i]   = v > 0 ? m_lut[int(v * 255.f)] : 0;
+    }
+    if (!m_texture) {
+        m_texture = Renderer::instance().createTexture();
+    }
+    if (m_texture->size().width != width || m_texture->size().height != height) {
+        m_texture->resize(width, height);
+    }
+    m_texture->update(0, 0, width, height, m_pixels.data());
+    ImPlot::PlotImage(label, m_texture->imguiTextureId(), { m_x.min(), m_y.min() }, { m_x.max(), m_y.max() });
+
+    if (m_peak > 0) {
+        m_window.scheduleRender();
+    }
+}
+
+namespace {
+// Columns of the overview computed over the whole data set
+constexpr int OVERVIEW_COLUMNS = 4096;
+// The quick pass of a level visits about this many points per column
+constexpr int QUICK_POINTS_PER_COLUMN = 16;
+} // namespace
+
+ProgressiveLine::ProgressiveLine(DataSet &dataSet, Window &window)
+    : m_dataSet(dataSet)
+    , m_window(window) {
+    m_listenerId = m_dataSet.addDataChangedListener([this](int, int) { dataChanged(); });
+    dataChanged();
+}
+
+ProgressiveLine::~ProgressiveLine() {
+    m_dataSet.removeDataChangedListener(m_listenerId);
+    // make the task give up on its current level and wait for it to return
+    m_latestGeneration = 0;
+    {
+        std::unique_lock lock(m_mutex);
+        m_quit = true;
+        m_condition.wait(lock, [this]() { return !m_running; });
+    }
+    // after the task returned, publish() reads m_alive on the worker thread
+    m_alive.reset();
+}
+
+void ProgressiveLine::schedule() {
+    if (!m_running) {
+        m_running = true;
+        Backend::threadPool().submit("progressive line", [this]() { run(); });
+    }
+}
+
+void ProgressiveLine::dataChanged() {
+    m_latestGeneration = ++m_generation;
+    {
+        std::lock_guard lock(m_mutex);
+        m_pendingOverview = m_generation;
+        schedule();
+    }
+}
+
+void ProgressiveLine::run() {
+    for (;;) {
+        std::optional<uint64_t> overview;
+        std::optional<Request>  request;
+        {
+            std::lock_guard lock(m_mutex);
+            if (m_quit || !(m_pendingOverview || m_pendingRequest)) {
+                m_running = false;
+                m_condition.notify_all();
+                return;
+            }
+            std::swap(overview, m_pendingOverview);
+            std::swap(request, m_pendingRequest);
+        }
+
+        if (overview) {
+            if (const auto range = dataRange(m_dataSet)) {
+                compute({ 0, *overview, AxisTransform::linear(range->first, range->second, 0, OVERVIEW_COLUMNS), OVERVIEW_COLUMNS }, true);
+            }
+        }
+        if (request) {
+            compute(*request, false);
+        }
+    }
+}
+
+void ProgressiveLine::compute(const Request &request, bool overview) {
+    const auto cancelled = [&]() {
+        return m_latestGeneration != request.generation || (!overview && m_latestRequest != request.id);
+    };
+    if (request.x.max() <= request.x.min() || cancelled()) {
+        return;
+    }
+
+    Envelope   points;
+    const auto finish = [&]() {
+        auto level        = std::make_shared<Level>();
+        level->generation = request.generation;
+        level->xmin       = request.x.min();
+        level->xmax       = request.x.max();
+        level->width      = request.width;
+        level->x          = std::move(points.x);
+        level->y          = std::move(points.y);
+        publish(std::move(level), overview);
+    };
+
+    // quick pass over a subset of the points, for views holding many points per column
+    const size_t visible = visibleCount(m_dataSet, request.x.min(), request.x.max());
+    const int    stride  = int(std::min<size_t>(visible / (size_t(request.width) * QUICK_POINTS_PER_COLUMN), std::numeric_limits<int>::max()));
+    if (stride > 1) {
+        if (!linePoints(m_dataSet, request.x, request.width, stride, points, cancelled)) {
+            return;
+        }
+        finish();
+    }
+
+    if (linePoints(m_dataSet, request.x, request.width, 1, points, cancelled)) {
+        finish();
+    }
+}
+
+void ProgressiveLine::publish(std::shared_ptr<Level> level, bool overview) {
+    Backend::instance().post([this, alive = std::weak_ptr<bool>(m_alive), level = std::move(level), overview]() {
+        if (!alive.lock() || level->generation != m_generation) {
+            return;
+        }
+        (overview ? m_overview : m_view) = level;
+        m_window.scheduleRender();
+    });
+}
+
+void ProgressiveLine::plot(const char *label) {
+    const auto x      = plotTransform(ImAxis_X1);
+    const auto xmin   = x.min();
+    const auto xmax   = x.max();
+    const int  width  = std::max(1, int(ImPlot::GetPlotSize().x));
+
+    if (m_lastRequest.generation != m_generation || m_lastRequest.x != x || m_lastRequest.width != width) {
+        m_lastRequest   = { m_lastRequest.id + 1, m_generation, x, width };
+        m_latestRequest = m_lastRequest.id;
+        {
+            std::lock_guard lock(m_mutex);
+            m_pendingRequest = m_lastRequest;
+            schedule();
+        }
+    }
+
+    // draw the finest level available for the view, the overview covers all the data
+    const auto   resolution = [](const Level &l) { return l.width / (l.xmax - l.xmin); };
+    const Level *level      = m_overview.get();
+    if (m_view && (!level || (m_view->xmin <= xmin && m_view->xmax >= xmax && resolution(*m_view) > resolution(*level)))) {
+        level = m_view.get();
+    }
+    if (!level) {
+        return;
+    }
+    const auto [start, end] = visibleRange(level->x, xmin, xmax);
+    ImPlot::PlotLine(label, level->x.data() + start, level->y.data() + start, end - start);
+}
+
+} // namespace ImChart::Plot
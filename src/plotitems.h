@@ -0,0 +1,299 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "transform.h"
+
+namespace ImChart {
+
+class DataSet;
+class DigitalDataSet;
+class MultiChannelDataSet;
+class SpatialIndex;
+class StreamStatistics;
+class WaterfallDataSet;
+class Window;
+
+namespace Renderer {
+class Texture;
+}
+
+/**
+ * Plot items for DataSets, to be called between ImPlot::BeginPlot() and ImPlot::EndPlot().
+ *
+ * The items expect the x values of the data set to be sorted. They map data to pixels with the
+ * batched AxisTransform of the plot axes, so decimation also follows logarithmic axes.
+ */
+namespace Plot {
+
+/**
+ * Draws the data set as a line, reading its values segment by segment. If the visible range holds
+ * more points than twice the plot width in pixels, the line is decimated to the min/max per pixel
+ * column. Segments falling entirely into one column contribute their precomputed summary (see
+ * DataSet::getSegmentSummary()) without their values being read.
+ */
+void line(const char *label, DataSet &dataSet);
+
+/**
+ * Draws all channels of the data set as lines, channel c shifted up by c * spacing and colored
+ * from the colormap. The visible part of the shared x axis is transformed and split into pixel
+ * columns once; every channel is then reduced to the min/max per column over contiguous runs of
+ * its y values. The lines are written straight into the plot draw list as quads, without an
+ * ImPlot item per channel, and the label only adds a legend entry.
+ */
+void channels(const char *label, MultiChannelDataSet &dataSet, float spacing = 0);
+
+/**
+ * Draws the channels of a DigitalDataSet as logic traces, channel c between c * spacing and
+ * c * spacing + height. Only the edges within the view are visited, so the cost scales with the
+ * number of transitions, not samples. Edges closer together than a pixel are merged into a filled
+ * block marking activity.
+ */
+void digital(const char *label, DigitalDataSet &dataSet, float height = 0.8f, float spacing = 1);
+
+/**
+ * @return the index of the data point closest to the mouse, if it is within 'maxPixels' pixels
+ * and the plot is hovered, -1 otherwise
+ */
+int hoveredPoint(SpatialIndex &index, float maxPixels = 8);
+
+/**
+ * Draws the y errors of the data set as error bars. If the visible range holds more points than
+ * the plot is wide in pixels, a single bar spanning the min/max envelope of all the errors falling
+ * into a pixel column is drawn instead of the individual bars.
+ */
+void errorBars(const char *label, DataSet &dataSet);
+
+/**
+ * Draws the y errors of the data set as a shaded band, decimated to the min/max envelope per
+ * pixel column like errorBars().
+ */
+void errorBand(const char *label, DataSet &dataSet);
+
+/**
+ * Overlays the statistics of a trace: its mean as a line, the band between p1 and p99 shaded and
+ * min/max as thin lines, each labelled at the right edge of the plot. With 'window', the windowed
+ * statistics are drawn instead of the totals. Only the summary is read, never the data set.
+ */
+void statistics(const char *label, const StreamStatistics &statistics, bool window = false);
+
+/**
+ * Draws a WaterfallDataSet with the newest row on top.
+ *
+ * The texture holds one texel row per ring row of the data set. Each frame, only the rows
+ * appended since the previous frame are mapped through the colormap and uploaded, and the ring
+ * is drawn as two image quads split at the newest row. The history scrolls by moving the texture
+ * coordinates, so the cost of an update is proportional to the row width, not the depth.
+ */
+class Waterfall {
+public:
+    explicit Waterfall(WaterfallDataSet &dataSet);
+    ~Waterfall();
+
+    // Values mapped to the ends of the colormap
+    void setRange(float min, float max);
+    void plot(const char *label);
+
+private:
+    void                               uploadRows();
+
+    WaterfallDataSet                  &m_dataSet;
+    std::unique_ptr<Renderer::Texture> m_texture;
+    uint64_t                           m_uploadedRows = 0;
+    float                              m_min          = 0;
+    float                              m_max          = 1;
+    std::vector<uint32_t>              m_lut;
+    std::vector<uint32_t>              m_row;
+};
+
+/**
+ * Heatmap of a grid of values held contiguously in one dimension of a data set, row by row, like
+ * the z values of SinDataSet2D. It replaces ImPlot::PlotHeatmap(), which samples the colormap per
+ * cell on the UI thread, with one texture drawn as an image quad.
+ *
+ * The values are mapped to RGBA8 through a lookup table sampled from the colormap. The rows are
+ * split over the thread pool, and each row is normalized and clamped over a block of contiguous
+ * values so the loop vectorizes, writing the colors straight into the upload buffer. Only the rows
+ * covered by the dataChanged() ranges since the previous frame are mapped and uploaded.
+ */
+class Heatmap {
+public:
+    Heatmap(DataSet &dataSet, int dimIndex, int columns, int rows);
+    ~Heatmap();
+
+    // Values mapped to the ends of the colormap
+    void setRange(float min, float max);
+    // Draws the grid between (x0, y0) and (x1, y1), its first row at the top like ImPlot::PlotHeatmap()
+    void plot(const char *label, double x0 = 0, double y0 = 0, double x1 = 1, double y1 = 1);
+
+private:
+    void                               dataChanged(int start, int count);
+    bool                               mapRows(int first, int last);
+
+    DataSet                           &m_dataSet;
+    const int                          m_dimIndex;
+    const int                          m_columns;
+    const int                          m_rows;
+    int                                m_listenerId;
+    float                              m_min        = 0;
+    float                              m_max        = 1;
+    // rows [m_dirtyFirst, m_dirtyLast) changed since they were uploaded
+    int                                m_dirtyFirst = 0;
+    int                                m_dirtyLast  = 0;
+    std::unique_ptr<Renderer::Texture> m_texture;
+    std::vector<uint32_t>              m_lut;
+    std::vector<uint32_t>              m_pixels;
+};
+
+/**
+ * Scatter plot of large data sets drawn as a point density image instead of markers.
+ *
+ * The points are counted into a buffer with one cell per plot pixel, in parallel with every
+ * worker filling its own partial buffer. The counts are mapped through the colormap on a log scale
+ * and uploaded into a texture, which is drawn as a single image quad. The counting only runs when
+ * the data or the view changes, other frames just draw the texture.
+ */
+class DensityScatter {
+public:
+    explicit DensityScatter(DataSet &dataSet);
+    ~DensityScatter();
+
+    void plot(const char *label);
+
+private:
+    void                               accumulate();
+
+    DataSet                           &m_dataSet;
+    int                                m_listenerId;
+    bool                               m_dirty  = true;
+    AxisTransform                      m_x;
+    AxisTransform                      m_y;
+    int                                m_width  = 0;
+    int                                m_height = 0;
+    std::unique_ptr<Renderer::Texture> m_texture;
+    std::vector<std::vector<uint32_t>> m_partials;
+    std::vector<uint32_t>              m_lut;
+    std::vector<uint32_t>              m_pixels;
+};
+
+/**
+ * Oscilloscope style persistence display of a data set updated repeatedly.
+ *
+ * Every update of the data set is rasterized once, as a line in plot pixel coordinates, into an
+ * intensity buffer, setting the pixels it crosses to full intensity. Each frame, the buffer decays
+ * with the elapsed time, is mapped through the colormap and uploaded into a texture drawn as one
+ * image quad. Older traces thus fade out without being redrawn. While anything is visible, the
+ * window is kept rendering so the fade continues without new data. Changing the view clears the
+ * buffer.
+ */
+class Persistence {
+public:
+    Persistence(DataSet &dataSet, Window &window);
+    ~Persistence();
+
+    // Time after which a trace has faded to 1 % of its intensity
+    void setDecayTime(std::chrono::duration<float> time) { m_decayTime = time; }
+    void plot(const char *label);
+
+private:
+    void                                  rasterize();
+    void                                  decay();
+
+    DataSet                              &m_dataSet;
+    Window                               &m_window;
+    int                                   m_listenerId;
+    std::chrono::duration<float>          m_decayTime = std::chrono::seconds(1);
+    std::chrono::steady_clock::time_point m_lastDecay;
+    AxisTransform                         m_x;
+    AxisTransform                         m_y;
+    int                                   m_width     = 0;
+    int                                   m_height    = 0;
+    float                                 m_peak      = 0; // upper bound of the intensities in the buffer
+    std::vector<float>                    m_intensity;
+    std::vector<float>                    m_px;
+    std::vector<float>                    m_py;
+    std::unique_ptr<Renderer::Texture>    m_texture;
+    std::vector<uint32_t>                 m_lut;
+    std::vector<uint32_t>                 m_pixels;
+};
+
+/**
+ * Line plot of very large data sets which never decimates on the UI thread.
+ *
+ * When the data changes, a task on the thread pool computes a coarse overview of the whole data set, the
+ * min/max of its y values in a fixed number of columns. When the view changes, the item draws the
+ * finest level it already has for the visible range right away and asks the task for the new
+ * view: first a quick min/max of a strided subset of the points, then the exact min/max per pixel
+ * column. Each level is posted to the UI thread as soon as it is ready, swapped in and rendered
+ * through Window::scheduleRender(). Work for a view which has been left again is abandoned.
+ *
+ * The data set is read from the thread pool, one segment at a time under DataSet::storageLock(),
+ * so segmented data sets may grow meanwhile. Data sets keeping their values in one array must not
+ * move it while the item exists.
+ */
+class ProgressiveLine {
+public:
+    ProgressiveLine(DataSet &dataSet, Window &window);
+    ~ProgressiveLine();
+
+    void plot(const char *label);
+
+private:
+    struct Level {
+        uint64_t           generation = 0;
+        float              xmin       = 0;
+        float              xmax       = 0;
+        int                width      = 0;
+        std::vector<float> x;
+        std::vector<float> y;
+    };
+
+    struct Request {
+        uint64_t      id         = 0;
+        uint64_t      generation = 0;
+        AxisTransform x;
+        int           width      = 0;
+    };
+
+    // Starts the task working off the pending requests unless it is running, m_mutex must be held
+    void                    schedule();
+    void                    run();
+    // Computes the quick and the exact level for the request, unless it gets superseded
+    void                    compute(const Request &request, bool overview);
+    void                    publish(std::shared_ptr<Level> level, bool overview);
+    void                    dataChanged();
+
+    DataSet                &m_dataSet;
+    Window                 &m_window;
+    int                     m_listenerId;
+
+    // UI thread state
+    uint64_t                m_generation = 0;
+    std::shared_ptr<Level>  m_overview;
+    std::shared_ptr<Level>  m_view;
+    Request                 m_lastRequest;
+
+    // shared with the task
+    std::mutex              m_mutex;
+    std::condition_variable m_condition;
+    std::optional<Request>  m_pendingRequest;
+    std::optional<uint64_t> m_pendingOverview;
+    std::atomic<uint64_t>   m_latestRequest    = 0;
+    std::atomic<uint64_t>   m_latestGeneration = 0;
+    bool                    m_quit             = false;
+    bool                    m_running          = false;
+    // Guards the levels posted to the UI thread against the destruction of the item
+    std::shared_ptr<bool>   m_alive = std::make_shared<bool>(true);
+};
+
+} // namespace Plot
+
+} // namespace ImChart
@@ -0,0 +1,586 @@
+#include "remote.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <span>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <fmt/format.h>
+
+#include <imgui.h>
+
+#include "window.h"
+
+namespace ImChart {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+static_assert(ImGuiKey_NamedKey_END - ImGuiKey_NamedKey_BEGIN <= int(sizeof(RemoteInput::keys) * 8));
+
+// Unchanged bytes in a row needed to end a run of changed ones, shorter runs cost more as a varint
+constexpr size_t MIN_UNCHANGED = 4;
+// Indices per PrimReserve() in the viewer, whole triangles below the 16 bit index limit
+constexpr int    INDEX_CHUNK   = 3 * 10000;
+
+constexpr size_t padding(size_t bytes) {
+    return (4 - bytes % 4) % 4;
+}
+
+void putVarint(std::vector<uint8_t> &out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(uint8_t(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(uint8_t(v));
+}
+
+bool getVarint(const uint8_t *&p, const uint8_t *end, uint64_t &v) {
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        const uint8_t b = *p++;
+        v |= uint64_t(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template<typename T>
+void append(std::vector<uint8_t> &out, const T *data, size_t count) {
+    const auto bytes = reinterpret_cast<const uint8_t *>(data);
+    out.insert(out.end(), bytes, bytes + count * sizeof(T));
+    out.resize(out.size() + padding(count * sizeof(T)));
+}
+
+void serialize(const ImDrawData *drawData, ImTextureID fontTexture, std::vector<uint8_t> &out) {
+    out.clear();
+    const RemoteDrawData data = { { drawData->DisplayPos.x, drawData->DisplayPos.y }, { drawData->DisplaySize.x, drawData->DisplaySize.y },
+        { drawData->FramebufferScale.x, drawData->FramebufferScale.y }, uint32_t(drawData->CmdListsCount), 0 };
+    append(out, &data, 1);
+
+    for (int i = 0; i < drawData->CmdListsCount; ++i) {
+        const auto          *list   = drawData->CmdLists[i];
+        const RemoteDrawList header = { uint32_t(list->CmdBuffer.Size), uint32_t(list->VtxBuffer.Size), uint32_t(list->IdxBuffer.Size), 0 };
+        append(out, &header, 1);
+        for (const auto &cmd : list->CmdBuffer) {
+            // callbacks only make sense in this process
+            const auto          elemCount = cmd.UserCallback ? 0u : cmd.ElemCount;
+            const RemoteDrawCmd c         = { { cmd.ClipRect.x, cmd.ClipRect.y, cmd.ClipRect.z, cmd.ClipRect.w },
+                        cmd.TextureId == fontTexture ? RemoteDrawCmd::FONT_TEXTURE : RemoteDrawCmd::OTHER_TEXTURE, cmd.VtxOffset, cmd.IdxOffset, elemCount };
+            append(out, &c, 1);
+        }
+        append(out, list->VtxBuffer.Data, list->VtxBuffer.Size);
+        append(out, list->IdxBuffer.Data, list->IdxBuffer.Size);
+    }
+}
+
+// Appends 'current' XORed with 'previous' and run length encoded to 'out'
+void encodeDelta(std::span<const uint8_t> current, std::span<const uint8_t> previous, std::vector<uint8_t> &out) {
+    const size_t n      = current.size();
+    const size_t common = std::min(n, previous.size());
+    const auto   base   = [&](size_t i) { return i < previous.size() ? previous[i] : uint8_t(0); };
+
+    for (size_t i = 0; i < n;) {
+        size_t end = i;
+        while (end + 8 <= common && std::memcmp(&current[end], &previous[end], 8) == 0) {
+            end += 8;
+        }
+        while (end < n && current[end] == base(end)) {
+            ++end;
+        }
+        if (end > i) {
+            putVarint(out, (end - i) << 1 | 1);
+            i = end;
+            continue;
+        }
+
+        size_t unchanged = 0;
+        while (end < n && unchanged < MIN_UNCHANGED) {
+            unchanged = current[end] == base(end) ? unchanged + 1 : 0;
+            ++end;
+        }
+        if (unchanged == MIN_UNCHANGED) {
+            end -= MIN_UNCHANGED;
+        }
+        putVarint(out, (end - i) << 1);
+        for (; i < end; ++i) {
+            out.push_back(current[i] ^ base(i));
+        }
+    }
+}
+
+bool decodeDelta(const uint8_t *p, const uint8_t *end, std::span<const uint8_t> previous, size_t rawSize, std::vector<uint8_t> &out) {
+    out.resize(rawSize);
+    const auto base = [&](size_t i) { return i < previous.size() ? previous[i] : uint8_t(0); };
+    for (size_t i = 0; i < rawSize;) {
+        uint64_t v;
+        if (!getVarint(p, end, v) || (v >> 1) > rawSize - i) {
+            return false;
+        }
+        const size_t length = v >> 1;
+        if (v & 1) {
+            const size_t copied = std::min(length, previous.size() > i ? previous.size() - i : 0);
+            std::memcpy(out.data() + i, previous.data() + i, copied);
+            std::memset(out.data() + i + copied, 0, length - copied);
+        } else {
+            if (size_t(end - p) < length) {
+                return false;
+            }
+            for (size_t k = 0; k < length; ++k) {
+                out[i + k] = p[k] ^ base(i + k);
+            }
+            p += length;
+        }
+        i += length;
+    }
+    return p == end;
+}
+
+// Reads everything available without blocking, false once the peer closed the connection
+bool readAvailable(int fd, std::vector<uint8_t> &buffer) {
+    for (;;) {
+        const size_t size = buffer.size();
+        buffer.resize(size + 65536);
+        const auto n = ::recv(fd, buffer.data() + size, 65536, MSG_DONTWAIT);
+        buffer.resize(size + std::max<ssize_t>(n, 0));
+        if (n > 0) {
+            continue;
+        }
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+    }
+}
+
+// The payload of the next complete message in 'buffer' after 'offset', advancing 'offset' past it
+const uint8_t *nextMessage(const std::vector<uint8_t> &buffer, size_t &offset, RemoteMessageHeader &header) {
+    if (buffer.size() - offset < sizeof(header)) {
+        return nullptr;
+    }
+    std::memcpy(&header, buffer.data() + offset, sizeof(header));
+    if (buffer.size() - offset - sizeof(header) < header.size) {
+        return nullptr;
+    }
+    const auto payload = buffer.data() + offset + sizeof(header);
+    offset += sizeof(header) + header.size;
+    return payload;
+}
+
+bool socketAddress(const std::string &path, sockaddr_un &addr) {
+    addr            = {};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        fmt::print(stderr, "The socket path '{}' is too long.\n", path);
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+} // namespace
+
+RemoteServer::RemoteServer(Window &window, int fd, std::string path)
+    : m_window(window)
+    , m_listenFd(fd)
+    , m_path(std::move(path)) {
+    m_window.onFrameRendered = [this]() { sendFrame(); };
+    accept(m_alive);
+}
+
+RemoteServer::~RemoteServer() {
+    m_alive.reset();
+    m_window.onFrameRendered = nullptr;
+    disconnect();
+    // shutting down wakes up accept() waiting on the socket, which then sees the server is gone
+    ::shutdown(m_listenFd, SHUT_RDWR);
+    ::close(m_listenFd);
+    ::unlink(m_path.c_str());
+}
+
+std::unique_ptr<RemoteServer> RemoteServer::listen(Window &window, const std::string &path) {
+    sockaddr_un addr;
+    if (!socketAddress(path, addr)) {
+        return nullptr;
+    }
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        fmt::print(stderr, "Unable to create the remote rendering socket: {}\n", strerror(errno));
+        return nullptr;
+    }
+    // a previous server which did not exit cleanly leaves its socket file behind
+    ::unlink(path.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || ::listen(fd, 1) != 0) {
+        fmt::print(stderr, "Unable to listen on '{}': {}\n", path, strerror(errno));
+        ::close(fd);
+        return nullptr;
+    }
+    return std::unique_ptr<RemoteServer>(new RemoteServer(window, fd, path));
+}
+
+Async::Task RemoteServer::accept(std::weak_ptr<bool> alive) {
+    for (;;) {
+        const bool ok = co_await Async::readable(m_listenFd);
+        if (alive.expired()) {
+            co_return;
+        }
+        if (!ok) {
+            fmt::print(stderr, "The remote rendering socket '{}' failed.\n", m_path);
+            co_return;
+        }
+        const int fd = ::accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        disconnect();
+        m_client = fd;
+        receive(fd, m_connection, alive);
+        // the new viewer starts with a complete frame
+        m_window.scheduleRender();
+    }
+}
+
+Async::Task RemoteServer::receive(int fd, uint64_t connection, std::weak_ptr<bool> alive) {
+    std::vector<uint8_t> buffer;
+    for (;;) {
+        co_await Async::readable(fd);
+        if (alive.expired() || connection != m_connection) {
+            co_return;
+        }
+        if (!readAvailable(fd, buffer)) {
+            disconnect();
+            co_return;
+        }
+        size_t              offset = 0;
+        RemoteMessageHeader header;
+        while (auto payload = nextMessage(buffer, offset, header)) {
+            if (header.type == RemoteMessageHeader::Input && header.size == sizeof(RemoteInput)) {
+                RemoteInput input;
+                std::memcpy(&input, payload, sizeof(input));
+                applyInput(input);
+            }
+        }
+        buffer.erase(buffer.begin(), buffer.begin() + offset);
+    }
+}
+
+Async::Task RemoteServer::flushWhenWritable(int fd, uint64_t connection, std::weak_ptr<bool> alive) {
+    co_await Async::writable(fd);
+    if (alive.expired() || connection != m_connection) {
+        co_return;
+    }
+    m_flushing = false;
+    flush();
+}
+
+void RemoteServer::sendFrame() {
+    m_context = ImGui::GetCurrentContext();
+    if (m_client < 0) {
+        return;
+    }
+    if (m_outPos < m_out.size()) {
+        ++m_stats.framesSkipped;
+        m_skipped = true;
+        return;
+    }
+
+    const auto start = Clock::now();
+    serialize(ImGui::GetDrawData(), ImGui::GetIO().Fonts->TexID, m_raw);
+    m_out.resize(sizeof(RemoteMessageHeader) + sizeof(RemoteFrameHeader));
+    encodeDelta(m_raw, m_previous, m_out);
+
+    const RemoteMessageHeader message = { RemoteMessageHeader::Frame, uint32_t(m_out.size() - sizeof(RemoteMessageHeader)) };
+    const RemoteFrameHeader   frame   = { m_frame++, uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count()),
+            uint32_t(m_raw.size()), 0 };
+    std::memcpy(m_out.data(), &message, sizeof(message));
+    std::memcpy(m_out.data() + sizeof(message), &frame, sizeof(frame));
+    std::swap(m_raw, m_previous);
+    m_outPos = 0;
+
+    ++m_stats.framesSent;
+    m_stats.rawBytes += m_previous.size();
+    m_stats.sentBytes += m_out.size();
+    m_stats.encodeTime += Clock::now() - start;
+    flush();
+}
+
+void RemoteServer::flush() {
+    while (m_outPos < m_out.size()) {
+        const auto n = ::send(m_client, m_out.data() + m_outPos, m_out.size() - m_outPos, MSG_NOSIGNAL);
+        if (n > 0) {
+            m_outPos += n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!m_flushing) {
+                m_flushing = true;
+                flushWhenWritable(m_client, m_connection, m_alive);
+            }
+            return;
+        } else {
+            disconnect();
+            return;
+        }
+    }
+    m_out.clear();
+    m_outPos = 0;
+    if (m_skipped) {
+        m_skipped = false;
+        m_window.scheduleRender();
+    }
+}
+
+void RemoteServer::disconnect() {
+    if (m_client >= 0) {
+        ::shutdown(m_client, SHUT_RDWR);
+        ::close(m_client);
+        m_client = -1;
+    }
+    // coroutines of the previous connection end when they resume
+    ++m_connection;
+    m_previous.clear();
+    m_out.clear();
+    m_outPos   = 0;
+    m_flushing = false;
+    m_skipped  = false;
+    m_input    = {};
+}
+
+void RemoteServer::applyInput(const RemoteInput &input) {
+    if (!m_context) {
+        return;
+    }
+    auto *current = ImGui::GetCurrentContext();
+    ImGui::SetCurrentContext(m_context);
+    auto &io = ImGui::GetIO();
+    if (input.mouseX != m_input.mouseX || input.mouseY != m_input.mouseY) {
+        io.AddMousePosEvent(input.mouseX, input.mouseY);
+    }
+    for (int b = 0; b < 5; ++b) {
+        const uint32_t bit = 1u << b;
+        if ((input.mouseButtons ^ m_input.mouseButtons) & bit) {
+            io.AddMouseButtonEvent(b, input.mouseButtons & bit);
+        }
+    }
+    if (input.wheelX != 0 || input.wheelY != 0) {
+        io.AddMouseWheelEvent(input.wheelX, input.wheelY);
+    }
+    for (int k = 0; k < ImGuiKey_NamedKey_END - ImGuiKey_NamedKey_BEGIN; ++k) {
+        const uint64_t bit = uint64_t(1) << (k % 64);
+        if ((input.keys[k / 64] ^ m_input.keys[k / 64]) & bit) {
+            io.AddKeyEvent(ImGuiKey(ImGuiKey_NamedKey_BEGIN + k), input.keys[k / 64] & bit);
+        }
+    }
+    for (uint32_t c = 0; c < std::min<uint32_t>(input.charCount, RemoteInput::MAX_CHARS); ++c) {
+        io.AddInputCharacter(input.chars[c]);
+    }
+    ImGui::SetCurrentContext(current);
+
+    m_input = input;
+    m_window.scheduleRender();
+}
+
+RemoteClient::RemoteClient(Window &window, int fd)
+    : m_window(window)
+    , m_fd(fd)
+    , m_rateStart(Clock::now()) {
+    receive(m_alive);
+}
+
+RemoteClient::~RemoteClient() {
+    m_alive.reset();
+    if (m_fd >= 0) {
+        ::shutdown(m_fd, SHUT_RDWR);
+        ::close(m_fd);
+    }
+}
+
+std::unique_ptr<RemoteClient> RemoteClient::connect(Window &window, const std::string &path) {
+    sockaddr_un addr;
+    if (!socketAddress(path, addr)) {
+        return nullptr;
+    }
+    // blocking, input messages are small and written whole; reads only happen once readable
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        fmt::print(stderr, "Unable to connect to the remote rendering server '{}': {}\n", path, strerror(errno));
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return nullptr;
+    }
+    return std::unique_ptr<RemoteClient>(new RemoteClient(window, fd));
+}
+
+Async::Task RemoteClient::receive(std::weak_ptr<bool> alive) {
+    for (;;) {
+        co_await Async::readable(m_fd);
+        if (alive.expired()) {
+            co_return;
+        }
+        if (!readAvailable(m_fd, m_in)) {
+            fmt::print(stderr, "The remote rendering server closed the connection.\n");
+            ::close(m_fd);
+            m_fd = -1;
+            m_window.scheduleRender();
+            co_return;
+        }
+        size_t              offset = 0;
+        RemoteMessageHeader header;
+        while (auto payload = nextMessage(m_in, offset, header)) {
+            if (header.type == RemoteMessageHeader::Frame) {
+                decode(payload, header.size);
+            }
+        }
+        m_in.erase(m_in.begin(), m_in.begin() + offset);
+    }
+}
+
+void RemoteClient::decode(const uint8_t *data, size_t size) {
+    RemoteFrameHeader frame;
+    if (size < sizeof(frame)) {
+        return;
+    }
+    std::memcpy(&frame, data, sizeof(frame));
+    if (!decodeDelta(data + sizeof(frame), data + size, m_frame, frame.rawSize, m_decoded)) {
+        fmt::print(stderr, "Dropping the corrupt remote frame {}.\n", frame.number);
+        return;
+    }
+    std::swap(m_frame, m_decoded);
+
+    const auto now     = Clock::now();
+    const auto bytes   = sizeof(RemoteMessageHeader) + size;
+    m_stats.latency    = now.time_since_epoch() - std::chrono::nanoseconds(frame.renderTime);
+    m_stats.maxLatency = std::max(m_stats.maxLatency, m_stats.latency);
+    ++m_stats.framesReceived;
+    m_stats.rawBytes += frame.rawSize;
+    m_stats.receivedBytes += bytes;
+
+    m_rateBytes += bytes;
+    const std::chrono::duration<double> elapsed = now - m_rateStart;
+    if (elapsed.count() >= 1) {
+        m_stats.bytesPerSecond = double(m_rateBytes) / elapsed.count();
+        m_rateBytes            = 0;
+        m_rateStart            = now;
+    }
+    m_window.scheduleRender();
+}
+
+void RemoteClient::render() {
+    if (m_fd >= 0) {
+        sendInput();
+    }
+    if (m_frame.size() < sizeof(RemoteDrawData)) {
+        return;
+    }
+
+    const uint8_t *p   = m_frame.data();
+    const uint8_t *end = p + m_frame.size();
+    RemoteDrawData data;
+    std::memcpy(&data, p, sizeof(data));
+    p += sizeof(data);
+
+    // the frame is in the coordinates of the server, drawn at the origin here
+    const ImVec2 offset = { -data.displayPos[0], -data.displayPos[1] };
+    const auto   font   = ImGui::GetIO().Fonts->TexID;
+    auto        *dl     = ImGui::GetBackgroundDrawList();
+
+    for (uint32_t l = 0; l < data.listCount; ++l) {
+        RemoteDrawList list;
+        if (size_t(end - p) < sizeof(list)) {
+            return;
+        }
+        std::memcpy(&list, p, sizeof(list));
+        p += sizeof(list);
+
+        const size_t cmdBytes = size_t(list.cmdCount) * sizeof(RemoteDrawCmd);
+        const size_t vtxBytes = size_t(list.vtxCount) * sizeof(ImDrawVert);
+        const size_t idxBytes = size_t(list.idxCount) * sizeof(ImDrawIdx);
+        if (size_t(end - p) < cmdBytes + vtxBytes + padding(vtxBytes) + idxBytes + padding(idxBytes)) {
+            return;
+        }
+        const uint8_t *cmds = p;
+        const uint8_t *vtx  = cmds + cmdBytes;
+        const uint8_t *idx  = vtx + vtxBytes + padding(vtxBytes);
+        p                   = idx + idxBytes + padding(idxBytes);
+
+        for (uint32_t c = 0; c < list.cmdCount; ++c) {
+            RemoteDrawCmd cmd;
+            std::memcpy(&cmd, cmds + c * sizeof(RemoteDrawCmd), sizeof(cmd));
+            if (cmd.texture != RemoteDrawCmd::FONT_TEXTURE || cmd.elemCount == 0 || cmd.idxOffset > list.idxCount
+                    || list.idxCount - cmd.idxOffset < cmd.elemCount) {
+                continue;
+            }
+            dl->PushClipRect({ cmd.clipRect[0] + offset.x, cmd.clipRect[1] + offset.y }, { cmd.clipRect[2] + offset.x, cmd.clipRect[3] + offset.y });
+            dl->PushTextureID(font);
+            // the vertices are copied in index order, so every chunk fits 16 bit indices
+            for (uint32_t done = 0; done < cmd.elemCount; done += INDEX_CHUNK) {
+                const int n = int(std::min<uint32_t>(INDEX_CHUNK, cmd.elemCount - done));
+                dl->PrimReserve(n, n);
+                for (int k = 0; k < n; ++k) {
+                    ImDrawIdx index;
+                    std::memcpy(&index, idx + size_t(cmd.idxOffset + done + k) * sizeof(ImDrawIdx), sizeof(index));
+                    const size_t v = std::min<size_t>(size_t(cmd.vtxOffset) + index, list.vtxCount - 1);
+                    ImDrawVert   vert;
+                    std::memcpy(&vert, vtx + v * sizeof(ImDrawVert), sizeof(vert));
+                    vert.pos.x += offset.x;
+                    vert.pos.y += offset.y;
+                    dl->_VtxWritePtr[k] = vert;
+                    dl->_IdxWritePtr[k] = ImDrawIdx(dl->_VtxCurrentIdx + k);
+                }
+                dl->_VtxWritePtr += n;
+                dl->_IdxWritePtr += n;
+                dl->_VtxCurrentIdx += n;
+            }
+            dl->PopTextureID();
+            dl->PopClipRect();
+        }
+    }
+}
+
+void RemoteClient::sendInput() {
+    const auto &io    = ImGui::GetIO();
+    RemoteInput input = {};
+    input.mouseX      = io.MousePos.x;
+    input.mouseY      = io.MousePos.y;
+    if (m_frame.size() >= sizeof(RemoteDrawData)) {
+        RemoteDrawData data;
+        std::memcpy(&data, m_frame.data(), sizeof(data));
+        input.mouseX += data.displayPos[0];
+        input.mouseY += data.displayPos[1];
+    }
+    for (int b = 0; b < 5; ++b) {
+        input.mouseButtons |= io.MouseDown[b] ? 1u << b : 0u;
+    }
+    for (int k = 0; k < ImGuiKey_NamedKey_END - ImGuiKey_NamedKey_BEGIN; ++k) {
+        if (ImGui::IsKeyDown(ImGuiKey(ImGuiKey_NamedKey_BEGIN + k))) {
+            input.keys[k / 64] |= uint64_t(1) << (k % 64);
+        }
+    }
+    // the wheel and characters are events of this frame, the rest is state sent when it changes
+    const bool events = io.MouseWheel != 0 || io.MouseWheelH != 0 || !io.InputQueueCharacters.empty();
+    if (!events && std::memcmp(&input, &m_input, sizeof(input)) == 0) {
+        return;
+    }
+    m_input         = input;
+    input.wheelX    = io.MouseWheelH;
+    input.wheelY    = io.MouseWheel;
+    input.charCount = uint32_t(std::min<int>(io.InputQueueCharacters.Size, RemoteInput::MAX_CHARS));
+    for (uint32_t c = 0; c < input.charCount; ++c) {
+        input.chars[c] = io.InputQueueCharacters[c];
+    }
+
+    uint8_t                   message[sizeof(RemoteMessageHeader) + sizeof(RemoteInput)];
+    const RemoteMessageHeader header = { RemoteMessageHeader::Input, sizeof(RemoteInput) };
+    std::memcpy(message, &header, sizeof(header));
+    std::memcpy(message + sizeof(header), &input, sizeof(input));
+    if (::send(m_fd, message, sizeof(message), MSG_NOSIGNAL) != ssize_t(sizeof(message))) {
+        fmt::print(stderr, "Unable to send the input to the remote rendering server: {}\n", strerror(errno));
+    }
+}
+
+} // namespace ImChart
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "async.h"
+
+struct ImGuiContext;
+
+namespace ImChart {
+
+class Window;
+
+/**
+ * Remote rendering over a local socket: the process owning the data sets renders its ImGui/ImPlot
+ * frames as usual and streams the draw data to thin viewers, which only draw it and send their
+ * input back.
+ *
+ * The stream is a sequence of messages, each a RemoteMessageHeader followed by 'size' bytes. A
+ * frame is the draw data serialized (a RemoteDrawData, then per draw list a RemoteDrawList, its
+ * commands, vertices and indices) and XORed with the previous frame sent, then run length encoded:
+ * varints of 'length << 1 | 1' for unchanged bytes and 'length << 1' followed by the XORed bytes
+ * for changed ones. Between two frames of a plot that did not change much, most bytes are equal.
+ *
+ * Only the font atlas is shared between the processes, both build the same default atlas. Draw
+ * commands using other textures are skipped by the viewer.
+ */
+struct RemoteMessageHeader {
+    enum Type : uint32_t {
+        Frame = 1, // RemoteFrameHeader + encoded frame, server to viewer
+        Input = 2  // RemoteInput, viewer to server
+    };
+
+    uint32_t type;
+    uint32_t size;
+};
+
+struct RemoteFrameHeader {
+    uint64_t number;
+    uint64_t renderTime; // steady clock in nanoseconds, when the frame was rendered
+    uint32_t rawSize;    // size of the serialized frame before encoding
+    uint32_t reserved;
+};
+
+struct RemoteDrawData {
+    float    displayPos[2];
+    float    displaySize[2];
+    float    framebufferScale[2];
+    uint32_t listCount;
+    uint32_t reserved;
+};
+
+struct RemoteDrawList {
+    uint32_t cmdCount;
+    uint32_t vtxCount;
+    uint32_t idxCount;
+    uint32_t reserved;
+};
+
+struct RemoteDrawCmd {
+    static constexpr uint32_t FONT_TEXTURE  = 0;
+    static constexpr uint32_t OTHER_TEXTURE = 1;
+
+    float                     clipRect[4];
+    uint32_t                  texture;
+    uint32_t                  vtxOffset;
+    uint32_t                  idxOffset;
+    uint32_t                  elemCount;
+};
+
+// The input state of the viewer, sent whenever it changes
+struct RemoteInput {
+    static constexpr int MAX_CHARS = 16;
+
+    float                mouseX;
+    float                mouseY;
+    uint32_t             mouseButtons; // bit per ImGuiMouseButton
+    float                wheelX;
+    float                wheelY;
+    uint32_t             charCount;
+    uint64_t             keys[4];      // bit per ImGuiKey, from ImGuiKey_NamedKey_BEGIN
+    uint32_t             chars[MAX_CHARS];
+};
+
+/**
+ * Streams the frames of a window to one viewer at a time, a new viewer replaces the previous one.
+ * When the viewer does not keep up, frames are skipped rather than queued, and the latest frame is
+ * sent once it caught up.
+ */
+class RemoteServer {
+public:
+    struct Stats {
+        uint64_t                 framesSent    = 0;
+        uint64_t                 framesSkipped = 0;
+        uint64_t                 rawBytes      = 0; // serialized draw data
+        uint64_t                 sentBytes     = 0; // after encoding
+        std::chrono::nanoseconds encodeTime    = {};
+    };
+
+    ~RemoteServer();
+
+    // Takes over window.onFrameRendered
+    static std::unique_ptr<RemoteServer> listen(Window &window, const std::string &path);
+
+    bool                                 isConnected() const { return m_client >= 0; }
+    const Stats                         &stats() const { return m_stats; }
+
+private:
+    RemoteServer(Window &window, int fd, std::string path);
+    Async::Task           accept(std::weak_ptr<bool> alive);
+    Async::Task           receive(int fd, uint64_t connection, std::weak_ptr<bool> alive);
+    Async::Task           flushWhenWritable(int fd, uint64_t connection, std::weak_ptr<bool> alive);
+    void                  sendFrame();
+    void                  flush();
+    void                  disconnect();
+    void                  applyInput(const RemoteInput &input);
+
+    Window               &m_window;
+    int                   m_listenFd;
+    std::string           m_path;
+    int                   m_client     = -1;
+    uint64_t              m_connection = 0;
+    ImGuiContext         *m_context    = nullptr;
+    uint64_t              m_frame      = 0;
+    std::vector<uint8_t>  m_raw;
+    std::vector<uint8_t>  m_previous;
+    std::vector<uint8_t>  m_out;
+    size_t                m_outPos   = 0;
+    bool                  m_flushing = false;
+    bool                  m_skipped  = false;
+    RemoteInput           m_input    = {};
+    Stats                 m_stats;
+    // Guards the coroutines waiting on the sockets against the destruction of the server
+    std::shared_ptr<bool> m_alive = std::make_shared<bool>(true);
+};
+
+/**
+ * Viewer of a RemoteServer. render() draws the latest frame received, call it from onRender:
+ *
+ *     auto client  = RemoteClient::connect(win, path);
+ *     win.onRender = [&]() { client->render(); };
+ */
+class RemoteClient {
+public:
+    struct Stats {
+        uint64_t                 framesReceived = 0;
+        uint64_t                 rawBytes       = 0;
+        uint64_t                 receivedBytes  = 0;
+        double                   bytesPerSecond = 0; // averaged over the last second with frames
+        std::chrono::nanoseconds latency        = {}; // rendered on the server to decoded here
+        std::chrono::nanoseconds maxLatency     = {};
+    };
+
+    ~RemoteClient();
+
+    static std::unique_ptr<RemoteClient> connect(Window &window, const std::string &path);
+
+    // Draws the latest frame into the background draw list and sends the input of this frame
+    void                                 render();
+
+    bool                                 isConnected() const { return m_fd >= 0; }
+    const Stats                         &stats() const { return m_stats; }
+
+private:
+    RemoteClient(Window &window, int fd);
+    Async::Task                           receive(std::weak_ptr<bool> alive);
+    void                                  decode(const uint8_t *data, size_t size);
+    void                                  sendInput();
+
+    Window                               &m_window;
+    int                                   m_fd;
+    std::vector<uint8_t>                  m_in;
+    std::vector<uint8_t>                  m_frame;
+    std::vector<uint8_t>                  m_decoded;
+    RemoteInput                           m_input = {};
+    Stats                                 m_stats;
+    std::chrono::steady_clock::time_point m_rateStart;
+    uint64_t                              m_rateBytes = 0;
+    std::shared_ptr<bool>                 m_alive     = std::make_shared<bool>(true);
+};
+
+} // namespace ImChart
@@ -1,5 +1,10 @@
 #include "openglrenderer.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
 #include <fmt/format.h>
 
 #include <GL/gl.h>
@@ -10,6 +15,65 @@
 
 namespace ImChart::Renderer {
 
+namespace {
+
+// OpenGL ES 3 entry points for the asynchronous readback, which GL/gl.h does not declare
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT 0x0001
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#endif
+#ifndef GL_ALREADY_SIGNALED
+#define GL_ALREADY_SIGNALED 0x911A
+#endif
+#ifndef GL_TIMEOUT_EXPIRED
+#define GL_TIMEOUT_EXPIRED 0x911B
+#endif
+#ifndef GL_CONDITION_SATISFIED
+#define GL_CONDITION_SATISFIED 0x911C
+#endif
+#ifndef GL_WAIT_FAILED
+#define GL_WAIT_FAILED 0x911D
+#endif
+
+struct GLES3Functions {
+    void(APIENTRY *genBuffers)(GLsizei, GLuint *);
+    void(APIENTRY *deleteBuffers)(GLsizei, const GLuint *);
+    void(APIENTRY *bindBuffer)(GLenum, GLuint);
+    void(APIENTRY *bufferData)(GLenum, ptrdiff_t, const void *, GLenum);
+    void *(APIENTRY *mapBufferRange)(GLenum, intptr_t, ptrdiff_t, GLbitfield);
+    GLboolean(APIENTRY *unmapBuffer)(GLenum);
+    void *(APIENTRY *fenceSync)(GLenum, GLbitfield);
+    GLenum(APIENTRY *clientWaitSync)(void *, GLbitfield, uint64_t);
+    void(APIENTRY *deleteSync)(void *);
+};
+
+GLES3Functions g_gl3;
+
+template<typename F>
+bool resolve(F &function, const char *name) {
+    function = reinterpret_cast<F>(eglGetProcAddress(name));
+    return function != nullptr;
+}
+
+bool loadGLES3Functions() {
+    return resolve(g_gl3.genBuffers, "glGenBuffers") && resolve(g_gl3.deleteBuffers, "glDeleteBuffers") && resolve(g_gl3.bindBuffer, "glBindBuffer")
+        && resolve(g_gl3.bufferData, "glBufferData") && resolve(g_gl3.mapBufferRange, "glMapBufferRange") && resolve(g_gl3.unmapBuffer, "glUnmapBuffer")
+        && resolve(g_gl3.fenceSync, "glFenceSync") && resolve(g_gl3.clientWaitSync, "glClientWaitSync") && resolve(g_gl3.deleteSync, "glDeleteSync");
+}
+
+} // namespace
+
 OpenGLRenderer *OpenGLRenderer::create() {
     auto nativeDisplay = Backend::instance().nativeDisplay();
 
@@ -48,20 +112,36 @@ OpenGLRenderer *OpenGLRenderer::create() {
         return nullptr;
     }
 
-    EGLint ctxattr[] = {
-        EGL_CONTEXT_CLIENT_VERSION, 2,
+    // Prefer ES 3 for the asynchronous frame readback, everything else only needs ES 2
+    int    glesVersion = 3;
+    EGLint ctxattr[]   = {
+        EGL_CONTEXT_CLIENT_VERSION, glesVersion,
         EGL_NONE
     };
     auto context = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, ctxattr);
+    if (context == EGL_NO_CONTEXT) {
+        glesVersion = ctxattr[1] = 2;
+        context                  = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, ctxattr);
+    }
     if (context == EGL_NO_CONTEXT) {
         fmt::print(stderr, "Unable to create EGL context (eglError: {})\n", eglGetError());
         return nullptr;
     }
+#ifdef EMSCRIPTEN
+    // WebGL has no buffer mapping
+    glesVersion = 2;
+#else
+    if (glesVersion == 3 && !loadGLES3Functions()) {
+        fmt::print(stderr, "OpenGL ES 3 buffer functions not found, frame capture will be synchronous.\n");
+        glesVersion = 2;
+    }
+#endif
 
-    auto renderer       = new OpenGLRenderer;
-    renderer->m_display = eglDisplay;
-    renderer->m_config  = config;
-    renderer->m_context = context;
+    auto renderer           = new OpenGLRenderer;
+    renderer->m_display     = eglDisplay;
+    renderer->m_config      = config;
+    renderer->m_context     = context;
+    renderer->m_glesVersion = glesVersion;
     return renderer;
 }
 
@@ -82,7 +162,19 @@ std::unique_ptr<Surface> OpenGLRenderer::createSurface(Backend::Window *window)
     s->m_window  = window;
     s->m_surface = surface;
 
-    ImGui_ImplOpenGL3_Init();
+    // All surfaces render with the one EGL context and the windows share their font atlas, so the
+    // backend is only initialized once and its state handed to the ImGui context of each window
+    ImGuiIO &io = ImGui::GetIO();
+    if (!m_imguiBackendData) {
+        ImGui_ImplOpenGL3_Init();
+        m_imguiBackendData  = io.BackendRendererUserData;
+        m_imguiBackendName  = io.BackendRendererName;
+        m_imguiBackendFlags = io.BackendFlags & ImGuiBackendFlags_RendererHasVtxOffset;
+    } else {
+        io.BackendRendererUserData = m_imguiBackendData;
+        io.BackendRendererName     = m_imguiBackendName;
+        io.BackendFlags |= m_imguiBackendFlags;
+    }
 
     auto col = ImGui::GetStyle().Colors[ImGuiCol_WindowBg];
     glClearColor(col.x, col.y, col.z, 1);
@@ -90,6 +182,17 @@ std::unique_ptr<Surface> OpenGLRenderer::createSurface(Backend::Window *window)
     return s;
 }
 
+std::unique_ptr<Texture> OpenGLRenderer::createTexture() {
+    auto t = std::make_unique<OpenGLTexture>();
+    glGenTextures(1, &t->m_texture);
+    glBindTexture(GL_TEXTURE_2D, t->m_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return t;
+}
+
 void OpenGLRenderer::begin() {
 }
 
@@ -115,9 +218,151 @@ bool OpenGLSurface::newFrame() {
 
 void OpenGLSurface::present() {
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    if (m_captureRequest) {
+        startReadback();
+    }
 
     auto r = static_cast<OpenGLRenderer *>(&instance());
     eglSwapBuffers(r->m_display, m_surface);
+    ++m_frameNumber;
+
+    collectReadbacks(false);
+    postCollect();
+}
+
+void OpenGLSurface::postCollect() {
+    // Windows only render when something changed, so the event loop picks up readbacks which did
+    // not complete by now, until they all did
+    const bool pending = std::any_of(std::begin(m_readbacks), std::end(m_readbacks), [](const Readback &rb) { return rb.done != nullptr; });
+    if (!pending || m_collectPosted) {
+        return;
+    }
+    m_collectPosted = Backend::instance().post([this, alive = std::weak_ptr<bool>(m_alive)]() {
+        if (!alive.lock()) {
+            return;
+        }
+        m_collectPosted = false;
+        makeCurrent();
+        collectReadbacks(true);
+        postCollect();
+    });
+}
+
+OpenGLSurface::~OpenGLSurface() {
+    if (static_cast<OpenGLRenderer *>(&instance())->m_glesVersion < 3) {
+        return;
+    }
+    makeCurrent();
+    for (auto &rb : m_readbacks) {
+        if (rb.fence) {
+            g_gl3.deleteSync(rb.fence);
+        }
+        if (rb.buffer) {
+            g_gl3.deleteBuffers(1, &rb.buffer);
+        }
+    }
+}
+
+void OpenGLSurface::makeCurrent() {
+    auto r = static_cast<OpenGLRenderer *>(&instance());
+    eglMakeCurrent(r->m_display, m_surface, m_surface, r->m_context);
+}
+
+bool OpenGLSurface::captureNextFrame(std::function<void(CapturedFrame &&)> done) {
+    const bool full = std::all_of(std::begin(m_readbacks), std::end(m_readbacks), [](const Readback &rb) { return rb.done != nullptr; });
+    if (m_captureRequest || full) {
+        return false;
+    }
+    m_captureRequest = std::move(done);
+    return true;
+}
+
+void OpenGLSurface::startReadback() {
+    auto          done  = std::move(m_captureRequest);
+    const auto    size  = m_window->pixelSize();
+    const size_t  bytes = size_t(size.width) * size.height * 4;
+    CapturedFrame frame = { m_frameNumber, size, {} };
+    m_captureRequest    = nullptr;
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    if (static_cast<OpenGLRenderer *>(&instance())->m_glesVersion < 3) {
+        // no pixel buffer objects, this stalls until the frame is rendered
+        frame.pixels.resize(bytes / 4);
+        glReadPixels(0, 0, size.width, size.height, GL_RGBA, GL_UNSIGNED_BYTE, frame.pixels.data());
+        done(std::move(frame));
+        return;
+    }
+
+    auto rb = std::find_if(std::begin(m_readbacks), std::end(m_readbacks), [](const Readback &rb) { return rb.done == nullptr; });
+    if (!rb->buffer) {
+        g_gl3.genBuffers(1, &rb->buffer);
+    }
+    g_gl3.bindBuffer(GL_PIXEL_PACK_BUFFER, rb->buffer);
+    g_gl3.bufferData(GL_PIXEL_PACK_BUFFER, ptrdiff_t(bytes), nullptr, GL_STREAM_READ);
+    // with a pack buffer bound the read is queued and the pointer is an offset into the buffer
+    glReadPixels(0, 0, size.width, size.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    g_gl3.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    rb->fence = g_gl3.fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    rb->frame = std::move(frame);
+    rb->done  = std::move(done);
+}
+
+void OpenGLSurface::collectReadbacks(bool wait) {
+    for (auto &rb : m_readbacks) {
+        if (!rb.done) {
+            continue;
+        }
+        const auto status = g_gl3.clientWaitSync(rb.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 1000000000 : 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            continue;
+        }
+        g_gl3.deleteSync(rb.fence);
+        rb.fence = nullptr;
+        if (status == GL_WAIT_FAILED) {
+            // release the buffer, the frame goes out without pixels
+            fmt::print(stderr, "Waiting for the readback of frame {} failed: 0x{:x}\n", rb.frame.number, glGetError());
+            auto done = std::move(rb.done);
+            rb.done   = nullptr;
+            done(std::move(rb.frame));
+            continue;
+        }
+
+        const auto   size  = rb.frame.size;
+        const size_t bytes = size_t(size.width) * size.height * 4;
+        rb.frame.pixels.resize(bytes / 4);
+        g_gl3.bindBuffer(GL_PIXEL_PACK_BUFFER, rb.buffer);
+        if (const void *data = g_gl3.mapBufferRange(GL_PIXEL_PACK_BUFFER, 0, ptrdiff_t(bytes), GL_MAP_READ_BIT)) {
+            std::memcpy(rb.frame.pixels.data(), data, bytes);
+            g_gl3.unmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        g_gl3.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        auto done = std::move(rb.done);
+        rb.done   = nullptr;
+        done(std::move(rb.frame));
+    }
+}
+
+OpenGLTexture::~OpenGLTexture() {
+    glDeleteTextures(1, &m_texture);
+}
+
+void OpenGLTexture::resize(int width, int height) {
+    std::vector<uint32_t> zeros(size_t(width) * height);
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, zeros.data());
+    m_size = { width, height };
+}
+
+void OpenGLTexture::update(int x, int y, int width, int height, const uint32_t *pixels) {
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+}
+
+void *OpenGLTexture::imguiTextureId() const {
+    return reinterpret_cast<void *>(intptr_t(m_texture));
 }
 
 } // namespace ImChart::Renderer
@@ -13,6 +13,7 @@ public:
     static OpenGLRenderer   *create();
 
     std::unique_ptr<Surface> createSurface(Backend::Window *window) override;
+    std::unique_ptr<Texture> createTexture() override;
 
     void                     begin() override;
     void                     end() override;
@@ -20,15 +21,63 @@ public:
     EGLDisplay               m_display;
     EGLConfig                m_config;
     EGLContext               m_context;
+    // 3 if the context is OpenGL ES 3, which allows asynchronous readback
+    int                      m_glesVersion = 2;
+
+private:
+    // The ImGui OpenGL backend state (shaders, buffers, font texture) of the first surface, shared
+    // by the ImGui contexts of all the others
+    void                    *m_imguiBackendData  = nullptr;
+    const char              *m_imguiBackendName  = nullptr;
+    int                      m_imguiBackendFlags = 0;
 };
 
 class OpenGLSurface : public Surface {
 public:
+    ~OpenGLSurface();
+
     bool             newFrame() override;
     void             present() override;
+    bool             captureNextFrame(std::function<void(CapturedFrame &&)> done) override;
 
     Backend::Window *m_window;
     EGLSurface       m_surface;
+
+private:
+    // A frame being copied into a pixel buffer object, fenced so it is only mapped once complete
+    struct Readback {
+        unsigned int                          buffer = 0;
+        void                                 *fence  = nullptr;
+        CapturedFrame                         frame;
+        std::function<void(CapturedFrame &&)> done;
+    };
+
+    void                                  makeCurrent();
+    void                                  startReadback();
+    void                                  collectReadbacks(bool wait);
+    void                                  postCollect();
+
+    // readbacks rotate over a few buffers, so frame N is read back while N + 1 renders
+    static constexpr int                  READBACK_BUFFERS = 3;
+    Readback                              m_readbacks[READBACK_BUFFERS];
+    std::function<void(CapturedFrame &&)> m_captureRequest;
+    uint64_t                              m_frameNumber    = 0;
+    bool                                  m_collectPosted  = false;
+    std::shared_ptr<bool>                 m_alive          = std::make_shared<bool>(true);
+};
+
+class OpenGLTexture : public Texture {
+public:
+    ~OpenGLTexture();
+
+    void         resize(int width, int height) override;
+    void         update(int x, int y, int width, int height, const uint32_t *pixels) override;
+
+    Size         size() const override { return m_size; }
+    void        *imguiTextureId() const override;
+
+    unsigned int m_texture = 0;
+    Size         m_size    = { 0, 0 };
 };
 
 }
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <vector>
+
+#include "utils.h"
 
 namespace ImChart {
 
@@ -11,23 +16,60 @@ class Window;
 namespace Renderer {
 
 class Surface;
+class Texture;
 
 class Renderer {
 public:
     virtual ~Renderer()                                                     = default;
 
     virtual std::unique_ptr<Surface> createSurface(Backend::Window *window) = 0;
+    // Must be called while rendering a window, i.e. between Surface::newFrame() and Surface::present()
+    virtual std::unique_ptr<Texture> createTexture()                        = 0;
 
     virtual void                     begin()                                = 0;
     virtual void                     end()                                  = 0;
 };
 
+// A frame read back from a Surface
+struct CapturedFrame {
+    uint64_t              number; // counts the frames presented by the surface
+    Size                  size;
+    // RGBA8 pixels, rows from the bottom to the top of the window as OpenGL returns them. Empty if
+    // the readback failed.
+    std::vector<uint32_t> pixels;
+};
+
 class Surface {
 public:
-    virtual ~Surface()      = default;
+    virtual ~Surface()                                                        = default;
+
+    virtual bool newFrame()                                                   = 0;
+    virtual void present()                                                    = 0;
+
+    /**
+     * Reads back the next presented frame and passes it to 'done', on the UI thread, once the
+     * pixels arrived. Renderers read back asynchronously where they can, so the frame is usually
+     * delivered a frame or two later. Hand the frame to another thread for any heavy processing,
+     * e.g. a FrameWriter.
+     *
+     * @return false if the capture was dropped because too many captures are still in flight
+     */
+    virtual bool captureNextFrame(std::function<void(CapturedFrame &&)> done) = 0;
+};
+
+// RGBA8 texture which can be drawn by ImGui and ImPlot, e.g. with ImPlot::PlotImage()
+class Texture {
+public:
+    virtual ~Texture()                                                                = default;
+
+    // Reallocates the texture, clearing it to transparent black
+    virtual void  resize(int width, int height)                                       = 0;
+    // Uploads tightly packed RGBA8 pixels into the given rectangle
+    virtual void  update(int x, int y, int width, int height, const uint32_t *pixels) = 0;
 
-    virtual bool newFrame() = 0;
-    virtual void present()  = 0;
+    virtual Size  size() const                                                        = 0;
+    // The texture id to pass to ImGui, i.e. an ImTextureID
+    virtual void *imguiTextureId() const                                              = 0;
 };
 
 bool      create();
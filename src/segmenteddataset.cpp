@@ -0,0 +1,150 @@
+#include "segmenteddataset.h"
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <new>
+
+#include "storage.h"
+
+namespace ImChart {
+
+namespace {
+
+void updateSummary(DataSet::SegmentSummary &summary, const float *values, int count) {
+    float lo = summary.min;
+    float hi = summary.max;
+    for (int i = 0; i < count; ++i) {
+        lo = std::min(lo, values[i]);
+        hi = std::max(hi, values[i]);
+    }
+    summary.min = lo;
+    summary.max = hi;
+    summary.count += count;
+}
+
+} // namespace
+
+SegmentedDataSet::SegmentedDataSet(int blockSize)
+    : m_blockSize(std::max(1, blockSize)) {
+}
+
+SegmentedDataSet::~SegmentedDataSet() {
+    clear();
+}
+
+float SegmentedDataSet::get(int dimIndex, int index) const {
+    return m_blocks[index / m_blockSize].values[dimIndex][index % m_blockSize];
+}
+
+std::span<float> SegmentedDataSet::getValues(int dimIndex) {
+    if (m_blocks.size() != 1) {
+        return {};
+    }
+    return getSegment(dimIndex, 0);
+}
+
+std::span<float> SegmentedDataSet::getSegment(int dimIndex, int segment) {
+    const auto &b = m_blocks[segment];
+    return { b.values[dimIndex], size_t(b.summary[dimIndex].count) };
+}
+
+const DataSet::SegmentSummary *SegmentedDataSet::getSegmentSummary(int dimIndex, int segment) const {
+    return &m_blocks[segment].summary[dimIndex];
+}
+
+size_t SegmentedDataSet::memoryUsage() const {
+    return m_blocks.size() * 2 * m_blockSize * sizeof(float) + m_blocks.capacity() * sizeof(Block);
+}
+
+void SegmentedDataSet::append(std::span<const float> xs, std::span<const float> ys) {
+    const int count = int(std::min(xs.size(), ys.size()));
+    const int start = m_count;
+    int       done  = 0;
+    try {
+        // readers on other threads index the block table while it grows, see DataSet::storageLock()
+        std::unique_lock lock(storageLock());
+        while (done < count) {
+            if (m_blocks.empty() || m_blocks.back().summary[0].count == m_blockSize) {
+                Block b;
+                for (int d = 0; d < 2; ++d) {
+                    b.values[d]  = static_cast<float *>(Storage::allocate(m_blockSize * sizeof(float)));
+                    b.summary[d] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(), 0 };
+                }
+                // the block is only owned once it is in the table, which can fail to grow as well
+                const auto release = [&]() {
+                    Storage::deallocate(b.values[0], m_blockSize * sizeof(float));
+                    Storage::deallocate(b.values[1], m_blockSize * sizeof(float));
+                };
+                if (!b.values[0] || !b.values[1]) {
+                    release();
+                    throw std::bad_alloc();
+                }
+                try {
+                    m_blocks.push_back(b);
+                } catch (...) {
+                    release();
+                    throw;
+                }
+            }
+
+            auto     &b      = m_blocks.back();
+            const int filled = b.summary[0].count;
+            const int n      = std::min(count - done, m_blockSize - filled);
+            std::copy_n(xs.data() + done, n, b.values[0] + filled);
+            std::copy_n(ys.data() + done, n, b.values[1] + filled);
+            updateSummary(b.summary[0], xs.data() + done, n);
+            updateSummary(b.summary[1], ys.data() + done, n);
+            done += n;
+            m_count += n;
+        }
+    } catch (...) {
+        // the points appended before an allocation failed stay
+        if (done > 0) {
+            dataChanged(start, done);
+        }
+        throw;
+    }
+    dataChanged(start, count);
+}
+
+void SegmentedDataSet::clear() {
+    bool hadData;
+    {
+        std::unique_lock lock(storageLock());
+        for (auto &b : m_blocks) {
+            Storage::deallocate(b.values[0], m_blockSize * sizeof(float));
+            Storage::deallocate(b.values[1], m_blockSize * sizeof(float));
+        }
+        m_blocks.clear();
+        hadData = m_count > 0;
+        m_count = 0;
+    }
+    if (hadData) {
+        dataChanged(0, 0);
+    }
+}
+
+std::pair<float, float> SegmentedDataSet::limits(int dimIndex, int start, int count) const {
+    float     lo  = std::numeric_limits<float>::max();
+    float     hi  = std::numeric_limits<float>::lowest();
+    const int end = std::min(m_count, start + count);
+    for (int i = std::max(0, start); i < end;) {
+        const auto &b        = m_blocks[i / m_blockSize];
+        const int   offset   = i % m_blockSize;
+        const int   blockEnd = std::min(end - i + offset, b.summary[dimIndex].count);
+        if (offset == 0 && blockEnd == b.summary[dimIndex].count) {
+            lo = std::min(lo, b.summary[dimIndex].min);
+            hi = std::max(hi, b.summary[dimIndex].max);
+        } else {
+            for (int j = offset; j < blockEnd; ++j) {
+                lo = std::min(lo, b.values[dimIndex][j]);
+                hi = std::max(hi, b.values[dimIndex][j]);
+            }
+        }
+        i += blockEnd - offset;
+    }
+    return { lo, hi };
+}
+
+} // namespace ImChart
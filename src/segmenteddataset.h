@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+
+#include <dataset.h>
+
+namespace ImChart {
+
+/**
+ * Append-only 2D data set storing its values in fixed-size blocks.
+ *
+ * Appending never moves existing values: when the last block is full, a new one is allocated
+ * from the DataSet storage pool, so long runs have no reallocation copies and values keep stable
+ * addresses. Every block keeps the min/max of its x and y values, updated on append, which lets
+ * limit computation and decimation use whole blocks without reading their values.
+ *
+ * The values are exposed through the segment interface of DataSet, one segment per block.
+ * getValues() only returns the values while they fit into the first block. append() and clear()
+ * hold storageLock() exclusively, readers on the thread pool hold it shared while they use a
+ * segment.
+ */
+class SegmentedDataSet : public DataSet {
+public:
+    explicit SegmentedDataSet(int blockSize = 1 << 16);
+    ~SegmentedDataSet();
+
+    SegmentedDataSet(const SegmentedDataSet &) = delete;
+    SegmentedDataSet &operator=(const SegmentedDataSet &) = delete;
+
+    float                 get(int dimIndex, int index) const final;
+    int                   getDataCount() const final { return m_count; }
+    int                   getDimension() const final { return 2; }
+    std::span<float>      getValues(int dimIndex) final;
+
+    int                   getSegmentCount() const final { return int(m_blocks.size()); }
+    std::span<float>      getSegment(int dimIndex, int segment) final;
+    const SegmentSummary *getSegmentSummary(int dimIndex, int segment) const final;
+
+    size_t                memoryUsage() const final;
+
+    int                   blockSize() const { return m_blockSize; }
+
+    // Throws std::bad_alloc if a block cannot be allocated, the points appended until then stay
+    void                  append(std::span<const float> xs, std::span<const float> ys);
+    void                  clear();
+
+    // Min/max of the values [start, start + count) of a dimension, reading only the partially covered blocks
+    std::pair<float, float> limits(int dimIndex, int start, int count) const;
+
+private:
+    struct Block {
+        float         *values[2];
+        SegmentSummary summary[2];
+    };
+
+    int                m_blockSize;
+    int                m_count = 0;
+    std::vector<Block> m_blocks;
+};
+
+} // namespace ImChart
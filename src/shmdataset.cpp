@@ -0,0 +1,227 @@
+#include "shmdataset.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <fmt/format.h>
+
+#include "backends/backend.h"
+
+namespace ImChart {
+
+namespace {
+
+constexpr size_t align64(size_t size) {
+    return (size + 63) & ~size_t(63);
+}
+
+size_t segmentSize(uint32_t capacity) {
+    return align64(sizeof(SharedMemoryHeader)) + 2 * align64(capacity * sizeof(float));
+}
+
+float *xArray(SharedMemoryHeader *header) {
+    return reinterpret_cast<float *>(reinterpret_cast<char *>(header) + align64(sizeof(SharedMemoryHeader)));
+}
+
+float *yArray(SharedMemoryHeader *header) {
+    return reinterpret_cast<float *>(reinterpret_cast<char *>(xArray(header)) + align64(header->capacity * sizeof(float)));
+}
+
+// Shared futexes, the segment is mapped by several processes so FUTEX_PRIVATE_FLAG must not be used
+void futexWake(std::atomic<uint32_t> *word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+void futexWait(std::atomic<uint32_t> *word, uint32_t value, const timespec &timeout) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT, value, &timeout, nullptr, 0);
+}
+
+} // namespace
+
+SharedMemoryWriter::~SharedMemoryWriter() {
+    if (m_header) {
+        munmap(m_header, m_size);
+        shm_unlink(m_name.c_str());
+    }
+}
+
+std::unique_ptr<SharedMemoryWriter> SharedMemoryWriter::create(const std::string &name, int capacity) {
+    const int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+    if (fd < 0) {
+        fmt::print(stderr, "Unable to create shared memory segment '{}': {}\n", name, strerror(errno));
+        return nullptr;
+    }
+
+    const size_t size = segmentSize(capacity);
+    if (ftruncate(fd, off_t(size)) != 0) {
+        fmt::print(stderr, "Unable to resize shared memory segment '{}': {}\n", name, strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+    auto mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        fmt::print(stderr, "Unable to map shared memory segment '{}': {}\n", name, strerror(errno));
+        return nullptr;
+    }
+
+    auto header      = new (mem) SharedMemoryHeader;
+    header->capacity = capacity;
+    header->sequence.store(0, std::memory_order_relaxed);
+    header->dataCount.store(0, std::memory_order_relaxed);
+    header->committedStart.store(0, std::memory_order_relaxed);
+    header->committedCount.store(0, std::memory_order_relaxed);
+    header->version = SharedMemoryHeader::VERSION;
+    // the magic is written last, viewers check it to see whether the segment is initialized
+    std::atomic_ref<uint32_t>(header->magic).store(SharedMemoryHeader::MAGIC, std::memory_order_release);
+
+    auto w      = std::unique_ptr<SharedMemoryWriter>(new SharedMemoryWriter);
+    w->m_name   = name;
+    w->m_size   = size;
+    w->m_header = header;
+    w->m_x      = xArray(header);
+    w->m_y      = yArray(header);
+    return w;
+}
+
+void SharedMemoryWriter::write(int start, std::span<const float> xs, std::span<const float> ys) {
+    const auto count = uint32_t(std::clamp<int64_t>(int64_t(std::min(xs.size(), ys.size())), 0, int64_t(capacity()) - start));
+    if (start < 0 || count == 0) {
+        return;
+    }
+
+    auto      &seq   = m_header->sequence;
+    const auto begin = seq.load(std::memory_order_relaxed);
+    seq.store(begin + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(m_x + start, xs.data(), count * sizeof(float));
+    std::memcpy(m_y + start, ys.data(), count * sizeof(float));
+    m_header->committedStart.store(start, std::memory_order_relaxed);
+    m_header->committedCount.store(count, std::memory_order_relaxed);
+    if (m_header->dataCount.load(std::memory_order_relaxed) < start + count) {
+        m_header->dataCount.store(start + count, std::memory_order_relaxed);
+    }
+
+    seq.store(begin + 2, std::memory_order_release);
+    futexWake(&seq);
+}
+
+SharedMemoryDataSet::~SharedMemoryDataSet() {
+    m_quit = true;
+    if (m_watcher.joinable()) {
+        futexWake(&m_header->sequence);
+        m_watcher.join();
+    }
+    if (m_header) {
+        munmap(m_header, m_size);
+    }
+}
+
+std::unique_ptr<SharedMemoryDataSet> SharedMemoryDataSet::open(const std::string &name) {
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        fmt::print(stderr, "Unable to open shared memory segment '{}': {}\n", name, strerror(errno));
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(SharedMemoryHeader)) {
+        fmt::print(stderr, "Shared memory segment '{}' is not initialized.\n", name);
+        close(fd);
+        return nullptr;
+    }
+    const size_t size = st.st_size;
+    auto         mem  = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        fmt::print(stderr, "Unable to map shared memory segment '{}': {}\n", name, strerror(errno));
+        return nullptr;
+    }
+
+    auto header = static_cast<SharedMemoryHeader *>(mem);
+    if (std::atomic_ref<uint32_t>(header->magic).load(std::memory_order_acquire) != SharedMemoryHeader::MAGIC
+            || header->version != SharedMemoryHeader::VERSION || segmentSize(header->capacity) > size) {
+        fmt::print(stderr, "Shared memory segment '{}' has an unexpected layout.\n", name);
+        munmap(mem, size);
+        return nullptr;
+    }
+
+    auto ds            = std::unique_ptr<SharedMemoryDataSet>(new SharedMemoryDataSet);
+    ds->m_size         = size;
+    ds->m_header       = header;
+    ds->m_x            = xArray(header);
+    ds->m_y            = yArray(header);
+    ds->m_capacity     = header->capacity;
+    ds->m_lastSequence = header->sequence.load(std::memory_order_acquire);
+    ds->m_watcher      = std::thread([ds = ds.get()]() { ds->watch(); });
+    return ds;
+}
+
+float SharedMemoryDataSet::get(int dimIndex, int index) const {
+    return (dimIndex == 0 ? m_x : m_y)[index];
+}
+
+int SharedMemoryDataSet::getDataCount() const {
+    // never trust the producer to stay within the arrays
+    return int(std::min(m_header->dataCount.load(std::memory_order_acquire), m_capacity));
+}
+
+std::span<float> SharedMemoryDataSet::getValues(int dimIndex) {
+    return { dimIndex == 0 ? m_x : m_y, size_t(getDataCount()) };
+}
+
+void SharedMemoryDataSet::watch() {
+    // the timeout only serves to notice m_quit
+    const timespec timeout = { 0, 100'000'000 };
+    uint32_t       seen    = m_lastSequence;
+    while (!m_quit) {
+        const auto seq = m_header->sequence.load(std::memory_order_acquire);
+        if (seq == seen || (seq & 1)) {
+            futexWait(&m_header->sequence, seq, timeout);
+            continue;
+        }
+        seen = seq;
+        // only keep one notification in flight, notify() picks up everything committed until it runs
+        if (!m_notifyQueued.exchange(true)) {
+            const bool posted = Backend::instance().post([this, alive = std::weak_ptr<bool>(m_alive)]() {
+                if (alive.lock()) {
+                    notify();
+                }
+            });
+            if (!posted) {
+                // try again with the next commit
+                m_notifyQueued = false;
+            }
+        }
+    }
+}
+
+void SharedMemoryDataSet::notify() {
+    m_notifyQueued = false;
+
+    const auto seq = m_header->sequence.load(std::memory_order_acquire);
+    if (seq == m_lastSequence) {
+        return;
+    }
+    const auto start = std::min(m_header->committedStart.load(std::memory_order_relaxed), m_capacity);
+    const auto count = std::min(m_header->committedCount.load(std::memory_order_relaxed), m_capacity - start);
+    // a single commit since the last notification: report its range, else everything may have changed
+    const bool single = seq - m_lastSequence == 2;
+    m_lastSequence    = seq;
+    if (single) {
+        dataChanged(int(start), int(count));
+    } else {
+        dataChanged(0, getDataCount());
+    }
+}
+
+} // namespace ImChart
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <dataset.h>
+
+namespace ImChart {
+
+/**
+ * Layout of the shared memory segment exchanged between a SharedMemoryWriter in the acquisition
+ * process and a SharedMemoryDataSet in the viewer. The header is followed by the x and the y
+ * array, each 'capacity' floats, starting at 64 byte aligned offsets.
+ *
+ * 'sequence' works as a seqlock: it is odd while the writer modifies the arrays, and is bumped to
+ * the next even value on commit. It is also the futex word the viewer waits on.
+ */
+struct SharedMemoryHeader {
+    static constexpr uint32_t MAGIC   = 0x494d4348; // "IMCH"
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t                  magic;
+    uint32_t                  version;
+    uint32_t                  capacity;
+    uint32_t                  reserved;
+    std::atomic<uint32_t>     sequence;
+    std::atomic<uint32_t>     dataCount;
+    std::atomic<uint32_t>     committedStart;
+    std::atomic<uint32_t>     committedCount;
+};
+
+/**
+ * Producer side: creates the segment and publishes data into it. Not a DataSet itself, it does
+ * not need a Backend and can be used from a plain acquisition process.
+ */
+class SharedMemoryWriter {
+public:
+    ~SharedMemoryWriter();
+
+    static std::unique_ptr<SharedMemoryWriter> create(const std::string &name, int capacity);
+
+    int                                        capacity() const { return int(m_header->capacity); }
+
+    // Writes the points [start, start + xs.size()) and wakes up the viewers
+    void                                       write(int start, std::span<const float> xs, std::span<const float> ys);
+
+private:
+    SharedMemoryWriter() = default;
+
+    std::string         m_name;
+    size_t              m_size   = 0;
+    SharedMemoryHeader *m_header = nullptr;
+    float              *m_x      = nullptr;
+    float              *m_y      = nullptr;
+};
+
+/**
+ * Viewer side: maps the segment of a SharedMemoryWriter read-only and returns spans directly into
+ * it, without copying. A watcher thread blocks on the futex of the header and posts a dataChanged()
+ * for the committed range to the UI thread through the Backend event loop, folding commits which
+ * arrive faster than the UI thread handles them.
+ *
+ * The spans point into memory the producer may be writing to; consumers needing a consistent
+ * snapshot can compare sequence() before and after reading.
+ */
+class SharedMemoryDataSet : public DataSet {
+public:
+    ~SharedMemoryDataSet();
+
+    static std::unique_ptr<SharedMemoryDataSet> open(const std::string &name);
+
+    float                                       get(int dimIndex, int index) const final;
+    int                                         getDataCount() const final;
+    int                                         getDimension() const final { return 2; }
+    // The memory is mapped read-only, the returned values must not be modified
+    std::span<float>                            getValues(int dimIndex) final;
+
+    size_t                                      memoryUsage() const final { return m_size; }
+
+    uint32_t                                    sequence() const { return m_header->sequence.load(std::memory_order_acquire); }
+
+private:
+    SharedMemoryDataSet() = default;
+    void                  watch();
+    void                  notify();
+
+    size_t                m_size         = 0;
+    SharedMemoryHeader   *m_header       = nullptr;
+    float                *m_x            = nullptr;
+    float                *m_y            = nullptr;
+    // validated against the mapping on open, the producer may change the header afterwards
+    uint32_t              m_capacity     = 0;
+    uint32_t              m_lastSequence = 0;
+    std::thread           m_watcher;
+    std::atomic<bool>     m_quit         = false;
+    std::atomic<bool>     m_notifyQueued = false;
+    // Guards the notifications posted to the UI thread against the destruction of the data set
+    std::shared_ptr<bool> m_alive        = std::make_shared<bool>(true);
+};
+
+} // namespace ImChart
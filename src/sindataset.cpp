@@ -2,6 +2,9 @@
 
 #include <cmath>
 
+#include "backends/backend.h"
+#include "parallel.h"
+
 namespace ImChart {
 
 SinDataSet::SinDataSet() {
@@ -19,11 +22,6 @@ SinDataSet::SinDataSet() {
         _xdata[i]     = x;
         _ydata[i]     = std::sin(_offset + x);
     }
-
-    _xPosErrors.resize(1e5, 0.3);
-    _xNegErrors.resize(1e5, 0.3);
-    _yPosErrors.resize(1e5, 0.2);
-    _yNegErrors.resize(1e5, 0.1);
 }
 
 SinDataSet::~SinDataSet() {
@@ -37,18 +35,18 @@ std::span<float> SinDataSet::getValues(int dimIndex) {
     return dimIndex == 0 ? _xdata : _ydata;
 }
 
-std::span<float> SinDataSet::getPositiveErrors(int dimIndex) {
-    return dimIndex == 0 ? _xPosErrors : _yPosErrors;
-}
-
-std::span<float> SinDataSet::getNegativeErrors(int dimIndex) {
-    return dimIndex == 0 ? _xNegErrors : _yNegErrors;
+std::span<const DataSet::ErrorSegment> SinDataSet::getErrorSegments(int dimIndex) const {
+    return { dimIndex == 0 ? &_xErrors : &_yErrors, 1 };
 }
 
 int SinDataSet::getDataCount() const {
     return 1e5;
 }
 
+size_t SinDataSet::memoryUsage() const {
+    return ImChart::memoryUsage(_xdata) + ImChart::memoryUsage(_ydata);
+}
+
 void SinDataSet::update() {
     _offset += 0.1;
 
@@ -72,20 +70,33 @@ SinDataSet2D::SinDataSet2D() {
 
     _xdata.resize(SIZE);
     _ydata.resize(SIZE);
-    _zdata.resize(SIZE*SIZE);
+    _zdata.resize(SIZE * SIZE);
 
-    for (int i = 0; i < SIZE; ++i) {
-        const float x = float(i) / 100.;
-        _xdata[i]     = x;
-        for (int j = 0; j < SIZE; ++j) {
-            const float y = float(j) / 100.;
-            _ydata[j] = y;
-            _zdata[i * SIZE + j]     = std::sin(_offset + x + y);
+    m_init = Backend::threadPool().async("SinDataSet2D init", [this, offset = _offset]() {
+        for (int i = 0; i < SIZE; ++i) {
+            _xdata[i] = float(i) / 100.;
+            _ydata[i] = float(i) / 100.;
         }
-    }
+        parallelFor(SIZE, 64, [this, offset](size_t begin, size_t end, int) {
+            for (size_t i = begin; i < end; ++i) {
+                for (int j = 0; j < SIZE; ++j) {
+                    _zdata[i * SIZE + j] = std::sin(offset + _xdata[i] + _ydata[j]);
+                }
+            }
+        }, "SinDataSet2D init rows");
+        Backend::instance().post([this, alive = std::weak_ptr<bool>(m_alive)]() {
+            if (alive.lock()) {
+                m_ready = true;
+                dataChanged(0, getDataCount());
+            }
+        });
+    });
 }
 
 SinDataSet2D::~SinDataSet2D() {
+    // the init task reads m_alive when it posts the ready callback
+    m_init.wait();
+    m_alive.reset();
 }
 
 float SinDataSet2D::get(int dimIndex, int index) const {
@@ -100,7 +111,15 @@ int SinDataSet2D::getDataCount() const {
     return SIZE*SIZE;
 }
 
+size_t SinDataSet2D::memoryUsage() const {
+    return ImChart::memoryUsage(_xdata) + ImChart::memoryUsage(_ydata) + ImChart::memoryUsage(_zdata);
+}
+
 void SinDataSet2D::update() {
+    // the values are still being computed, the ready callback emits dataChanged()
+    if (!m_ready) {
+        return;
+    }
     _offset += 0.1;
 
     // for (int i = 0; i < 1e5; ++i) {
@@ -1,7 +1,9 @@
 #pragma once
 
-#include <vector>
+#include <future>
+#include <memory>
 
+#include "storage.h"
 #include "timer.h"
 #include <dataset.h>
 
@@ -19,19 +21,19 @@ public:
     int              getDimension() const final { return 2; }
     std::span<float> getValues(int dimIndex) final;
 
-    std::span<float> getPositiveErrors(int dimIndex) final;
-    std::span<float> getNegativeErrors(int dimIndex) final;
+    ErrorType                     getErrorType(int dimIndex) const final { return ErrorType::Uniform; }
+    std::span<const ErrorSegment> getErrorSegments(int dimIndex) const final;
+
+    size_t           memoryUsage() const final;
 
     void             update();
 
 private:
     double             _offset = 0;
-    std::vector<float> _xdata;
-    std::vector<float> _ydata;
-    std::vector<float> _xPosErrors;
-    std::vector<float> _xNegErrors;
-    std::vector<float> _yPosErrors;
-    std::vector<float> _yNegErrors;
+    FloatStorage       _xdata;
+    FloatStorage       _ydata;
+    ErrorSegment       _xErrors = { 0, 0.3, 0.3 };
+    ErrorSegment       _yErrors = { 0, 0.2, 0.1 };
     Timer              m_timer;
 };
 
@@ -46,14 +48,21 @@ public:
     int              getDimension() const final { return 3; }
     std::span<float> getValues(int dimIndex) final;
 
+    size_t           memoryUsage() const final;
+    bool             isReady() const final { return m_ready; }
+
     void             update();
 
 private:
-    double             _offset = 0;
-    std::vector<float> _xdata;
-    std::vector<float> _ydata;
-    std::vector<float> _zdata;
-    Timer              m_timer;
+    double                _offset = 0;
+    FloatStorage          _xdata;
+    FloatStorage          _ydata;
+    FloatStorage          _zdata;
+    Timer                 m_timer;
+    // the values are computed in the background, so the first frame does not wait for them
+    bool                  m_ready = false;
+    std::future<void>     m_init;
+    std::shared_ptr<bool> m_alive = std::make_shared<bool>(true);
 };
 
 } // namespace ImChart
@@ -0,0 +1,276 @@
+#include "spatialindex.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "dataset.h"
+#include "transform.h"
+
+namespace ImChart {
+
+namespace {
+
+// Average number of points per grid cell
+constexpr float  POINTS_PER_CELL = 2.f;
+constexpr int    MAX_CELLS       = 4096; // per axis
+// Appended points kept in the list before the grid is rebuilt, at least
+constexpr size_t MIN_APPENDED    = 1024;
+
+} // namespace
+
+SpatialIndex::SpatialIndex(DataSet &dataSet)
+    : m_dataSet(dataSet) {
+    m_listenerId = m_dataSet.addDataChangedListener([this](int start, int) {
+        // appended points are picked up by the next query
+        if (start < m_indexed) {
+            invalidate();
+        }
+    });
+}
+
+SpatialIndex::~SpatialIndex() {
+    m_dataSet.removeDataChangedListener(m_listenerId);
+}
+
+int SpatialIndex::cellX(float x) const {
+    return std::clamp(int((x - m_xmin) * m_xInvCell), 0, m_nx - 1);
+}
+
+int SpatialIndex::cellY(float y) const {
+    return std::clamp(int((y - m_ymin) * m_yInvCell), 0, m_ny - 1);
+}
+
+void SpatialIndex::update() {
+    if (m_valid && m_dataSet.getDataCount() < m_indexed) {
+        m_valid = false;
+    }
+    if (!m_valid) {
+        build();
+    } else if (m_dataSet.getDataCount() > m_indexed) {
+        collectAppended();
+        if (m_appendedIndex.size() > std::max(MIN_APPENDED, m_index.size() / 8)) {
+            build();
+        }
+    }
+}
+
+void SpatialIndex::collectAppended() {
+    const int segments = m_dataSet.getSegmentCount();
+    int       offset   = 0;
+    for (int s = 0; s < segments; ++s) {
+        const auto xs = m_dataSet.getSegment(0, s);
+        const auto ys = m_dataSet.getSegment(1, s);
+        const int  n  = int(std::min(xs.size(), ys.size()));
+        for (int i = std::max(0, m_indexed - offset); i < n; ++i) {
+            if (!std::isnan(xs[i]) && !std::isnan(ys[i])) {
+                m_appendedX.push_back(xs[i]);
+                m_appendedY.push_back(ys[i]);
+                m_appendedIndex.push_back(offset + i);
+            }
+        }
+        offset += n;
+    }
+    m_indexed = std::max(m_indexed, offset);
+}
+
+void SpatialIndex::build() {
+    m_valid            = true;
+    const int segments = m_dataSet.getSegmentCount();
+    m_appendedX.clear();
+    m_appendedY.clear();
+    m_appendedIndex.clear();
+
+    // bounds, std::min/max skip NaNs as they compare false
+    float     xmin     = std::numeric_limits<float>::max();
+    float     xmax     = std::numeric_limits<float>::lowest();
+    float     ymin     = xmin;
+    float     ymax     = xmax;
+    size_t    count    = 0;
+    for (int s = 0; s < segments; ++s) {
+        const auto xs = m_dataSet.getSegment(0, s);
+        const auto ys = m_dataSet.getSegment(1, s);
+        const auto n  = std::min(xs.size(), ys.size());
+        for (size_t i = 0; i < n; ++i) {
+            xmin = std::min(xmin, xs[i]);
+            xmax = std::max(xmax, xs[i]);
+            ymin = std::min(ymin, ys[i]);
+            ymax = std::max(ymax, ys[i]);
+        }
+        count += n;
+    }
+    m_indexed = int(count);
+    m_x.clear();
+    m_y.clear();
+    m_index.clear();
+    m_nx = m_ny = 0;
+    if (count == 0 || xmin > xmax || ymin > ymax) {
+        return;
+    }
+
+    const int side = std::clamp(int(std::sqrt(count / POINTS_PER_CELL)), 1, MAX_CELLS);
+    m_nx           = side;
+    m_ny           = side;
+    m_xmin         = xmin;
+    m_ymin         = ymin;
+    m_xInvCell     = xmax > xmin ? m_nx / (xmax - xmin) : 0.f;
+    m_yInvCell     = ymax > ymin ? m_ny / (ymax - ymin) : 0.f;
+
+    // counting sort of the points by cell, points with a NaN coordinate are left out
+    const int        cells = m_nx * m_ny;
+    std::vector<int> cellOf(count);
+    size_t           offset = 0;
+    m_cellStart.assign(cells + 1, 0);
+    for (int s = 0; s < segments; ++s) {
+        const auto xs = m_dataSet.getSegment(0, s);
+        const auto ys = m_dataSet.getSegment(1, s);
+        const auto n  = std::min(xs.size(), ys.size());
+        for (size_t i = 0; i < n; ++i) {
+            const bool valid   = !std::isnan(xs[i]) && !std::isnan(ys[i]);
+            const int  cell    = valid ? cellY(ys[i]) * m_nx + cellX(xs[i]) : -1;
+            cellOf[offset + i] = cell;
+            ++m_cellStart[cell + 1];
+        }
+        offset += n;
+    }
+    // points with NaNs were counted in m_cellStart[0], drop them
+    const int invalid = m_cellStart[0];
+    m_cellStart[0]    = 0;
+    for (int c = 0; c < cells; ++c) {
+        m_cellStart[c + 1] += m_cellStart[c];
+    }
+
+    const size_t     indexed = count - invalid;
+    std::vector<int> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+    m_x.resize(indexed);
+    m_y.resize(indexed);
+    m_index.resize(indexed);
+    offset = 0;
+    for (int s = 0; s < segments; ++s) {
+        const auto xs = m_dataSet.getSegment(0, s);
+        const auto ys = m_dataSet.getSegment(1, s);
+        const auto n  = std::min(xs.size(), ys.size());
+        for (size_t i = 0; i < n; ++i) {
+            const int cell = cellOf[offset + i];
+            if (cell < 0) {
+                continue;
+            }
+            const int slot = fill[cell]++;
+            m_x[slot]      = xs[i];
+            m_y[slot]      = ys[i];
+            m_index[slot]  = int(offset + i);
+        }
+        offset += n;
+    }
+}
+
+template<typename Visit>
+void SpatialIndex::forEachInRect(float xmin, float xmax, float ymin, float ymax, Visit visit) {
+    update();
+    for (size_t i = 0; i < m_appendedIndex.size(); ++i) {
+        if (m_appendedX[i] >= xmin && m_appendedX[i] <= xmax && m_appendedY[i] >= ymin && m_appendedY[i] <= ymax) {
+            visit(m_appendedX[i], m_appendedY[i], m_appendedIndex[i]);
+        }
+    }
+    if (m_index.empty()) {
+        return;
+    }
+
+    const int x0 = cellX(xmin);
+    const int x1 = cellX(xmax);
+    const int y0 = cellY(ymin);
+    const int y1 = cellY(ymax);
+    for (int iy = y0; iy <= y1; ++iy) {
+        for (int i = m_cellStart[iy * m_nx + x0]; i < m_cellStart[iy * m_nx + x1 + 1]; ++i) {
+            if (m_x[i] >= xmin && m_x[i] <= xmax && m_y[i] >= ymin && m_y[i] <= ymax) {
+                visit(m_x[i], m_y[i], m_index[i]);
+            }
+        }
+    }
+}
+
+int SpatialIndex::nearest(float x, float y, float xScale, float yScale, float maxDistance) {
+    update();
+    float      best    = maxDistance * maxDistance;
+    int        found   = -1;
+    const auto measure = [&](float px, float py, int index) {
+        const float dx = (px - x) * xScale;
+        const float dy = (py - y) * yScale;
+        const float d  = dx * dx + dy * dy;
+        if (d <= best) {
+            best  = d;
+            found = index;
+        }
+    };
+    for (size_t i = 0; i < m_appendedIndex.size(); ++i) {
+        measure(m_appendedX[i], m_appendedY[i], m_appendedIndex[i]);
+    }
+    if (m_index.empty()) {
+        return found;
+    }
+
+    const int   cx    = cellX(x);
+    const int   cy    = cellY(y);
+    // every cell of ring r is at least r - 1 cells away from the query along one axis
+    const float cw    = m_xInvCell > 0 ? xScale / m_xInvCell : std::numeric_limits<float>::infinity();
+    const float ch    = m_yInvCell > 0 ? yScale / m_yInvCell : std::numeric_limits<float>::infinity();
+    const float step  = std::min(cw, ch);
+
+    const auto  visit = [&](int ix, int iy) {
+        const int cell = iy * m_nx + ix;
+        for (int i = m_cellStart[cell]; i < m_cellStart[cell + 1]; ++i) {
+            measure(m_x[i], m_y[i], m_index[i]);
+        }
+    };
+
+    const int maxRing = std::max({ cx, m_nx - 1 - cx, cy, m_ny - 1 - cy });
+    for (int r = 0; r <= maxRing; ++r) {
+        const float bound = (r - 1) * step;
+        if (r > 1 && bound * bound > best) {
+            break;
+        }
+        const int y0 = std::max(0, cy - r);
+        const int y1 = std::min(m_ny - 1, cy + r);
+        for (int iy = y0; iy <= y1; ++iy) {
+            if (iy == cy - r || iy == cy + r) {
+                for (int ix = std::max(0, cx - r); ix <= std::min(m_nx - 1, cx + r); ++ix) {
+                    visit(ix, iy);
+                }
+                continue;
+            }
+            if (cx - r >= 0) {
+                visit(cx - r, iy);
+            }
+            if (r > 0 && cx + r < m_nx) {
+                visit(cx + r, iy);
+            }
+        }
+    }
+    return found;
+}
+
+int SpatialIndex::nearest(const AxisTransform &xAxis, const AxisTransform &yAxis, float px, float py, float maxPixels) {
+    // the points within the pixel box are found in data space, the transforms are monotonic, and
+    // measured in pixels, which are not linear in the values on log axes
+    const float x0 = xAxis.fromPixel(px - maxPixels);
+    const float x1 = xAxis.fromPixel(px + maxPixels);
+    const float y0 = yAxis.fromPixel(py - maxPixels);
+    const float y1 = yAxis.fromPixel(py + maxPixels);
+    float       best  = maxPixels * maxPixels;
+    int         found = -1;
+    forEachInRect(std::min(x0, x1), std::max(x0, x1), std::min(y0, y1), std::max(y0, y1), [&](float x, float y, int index) {
+        const float dx = xAxis.toPixel(x) - px;
+        const float dy = yAxis.toPixel(y) - py;
+        const float d  = dx * dx + dy * dy;
+        if (d <= best) {
+            best  = d;
+            found = index;
+        }
+    });
+    return found;
+}
+
+void SpatialIndex::query(float xmin, float xmax, float ymin, float ymax, std::vector<int> &indices) {
+    forEachInRect(xmin, xmax, ymin, ymax, [&](float, float, int index) { indices.push_back(index); });
+}
+
+} // namespace ImChart
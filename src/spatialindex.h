@@ -0,0 +1,77 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+
+namespace ImChart {
+
+class AxisTransform;
+class DataSet;
+
+/**
+ * Uniform grid over the (x, y) points of a 2D data set, for hover feedback and picking.
+ *
+ * The index is built on the first query after the data changed: the points are sorted into about
+ * two points per cell, and their coordinates are copied in cell order, so a query only touches
+ * the memory of the cells it visits. A dataChanged() of points already indexed invalidates the
+ * index. Points appended behind them are only collected by the next query, into a list which
+ * queries scan in full, until it outgrows an eighth of the grid and the index is rebuilt.
+ *
+ * Point indices refer to the data set, counting across all its segments.
+ */
+class SpatialIndex {
+public:
+    explicit SpatialIndex(DataSet &dataSet);
+    ~SpatialIndex();
+
+    SpatialIndex(const SpatialIndex &)            = delete;
+    SpatialIndex &operator=(const SpatialIndex &) = delete;
+
+    /**
+     * Finds the point closest to (x, y).
+     *
+     * Distances are measured after scaling the x and y differences by 'xScale' and 'yScale', e.g.
+     * pixels per data unit to pick in pixel space.
+     *
+     * @return the index of the point, or -1 if there is no point within 'maxDistance'
+     */
+    int  nearest(float x, float y, float xScale = 1, float yScale = 1, float maxDistance = std::numeric_limits<float>::infinity());
+    // Finds the point closest to the pixel (px, py) of the axis transforms, also on log axes
+    int  nearest(const AxisTransform &xAxis, const AxisTransform &yAxis, float px, float py, float maxPixels);
+
+    // Appends the indices of the points within the rectangle to 'indices'
+    void query(float xmin, float xmax, float ymin, float ymax, std::vector<int> &indices);
+
+    void invalidate() { m_valid = false; }
+
+private:
+    void               update();
+    void               build();
+    void               collectAppended();
+    // Calls visit(x, y, index) for the points within the rectangle
+    template<typename Visit>
+    void               forEachInRect(float xmin, float xmax, float ymin, float ymax, Visit visit);
+    int                cellX(float x) const;
+    int                cellY(float y) const;
+
+    DataSet           &m_dataSet;
+    int                m_listenerId;
+    bool               m_valid    = false;
+    int                m_indexed  = 0; // points of the data set covered by the grid and the list
+    float              m_xmin     = 0;
+    float              m_ymin     = 0;
+    float              m_xInvCell = 0;
+    float              m_yInvCell = 0;
+    int                m_nx       = 0;
+    int                m_ny       = 0;
+    std::vector<int>   m_cellStart; // m_nx * m_ny + 1 offsets into the arrays below
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<int>   m_index;
+    // points appended since the grid was built
+    std::vector<float> m_appendedX;
+    std::vector<float> m_appendedY;
+    std::vector<int>   m_appendedIndex;
+};
+
+} // namespace ImChart
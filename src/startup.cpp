@@ -0,0 +1,49 @@
+#include "startup.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace ImChart::Startup {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// initialized before main(), close enough to the start of the process
+const Clock::time_point                                g_start   = Clock::now();
+std::vector<std::pair<const char *, Clock::time_point>> g_steps;
+bool                                                   g_started = true;
+
+} // namespace
+
+void mark(const char *step) {
+    if (g_started) {
+        g_steps.emplace_back(step, Clock::now());
+    }
+}
+
+void framePresented() {
+    if (!g_started) {
+        return;
+    }
+    mark("first frame presented");
+    g_started = false;
+
+    if (std::getenv("IMCHART_STARTUP_REPORT")) {
+        fmt::print("Startup:\n");
+        auto previous = g_start;
+        for (const auto &[step, time] : g_steps) {
+            const auto total = std::chrono::duration<double, std::milli>(time - g_start).count();
+            const auto delta = std::chrono::duration<double, std::milli>(time - previous).count();
+            fmt::print("  {:8.1f} ms  (+{:7.1f} ms)  {}\n", total, delta, step);
+            previous = time;
+        }
+    }
+    g_steps = {};
+}
+
+} // namespace ImChart::Startup
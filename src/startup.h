@@ -0,0 +1,16 @@
+#pragma once
+
+namespace ImChart::Startup {
+
+/**
+ * Startup timing report, printed once the first frame was presented if the environment variable
+ * IMCHART_STARTUP_REPORT is set. The times are relative to the start of the process.
+ */
+
+// Records that the given startup step finished. 'step' must be a string literal.
+void mark(const char *step);
+
+// Called by the backends after presenting a frame, prints the report after the first one
+void framePresented();
+
+} // namespace ImChart::Startup
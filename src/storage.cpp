@@ -0,0 +1,166 @@
+#include "storage.h"
+
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include <fmt/format.h>
+
+namespace ImChart::Storage {
+
+namespace {
+
+struct Pool {
+    std::mutex                                       mutex;
+    std::unordered_map<size_t, std::vector<void *>> blocks;
+    size_t                                           pooledBytes    = 0;
+    size_t                                           allocatedBytes = 0;
+    size_t                                           limit          = size_t(256) * 1024 * 1024;
+    HugePages                                        hugePages      = HugePages::Transparent;
+};
+
+Pool &pool() {
+    static Pool p;
+    return p;
+}
+
+// Small blocks are rounded to powers of two, mapped blocks to whole huge pages. The rounding makes
+// blocks of datasets that get resized back and forth hit the same pool bucket.
+size_t blockSize(size_t bytes) {
+    if (bytes >= HUGE_PAGE_SIZE) {
+        return (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    }
+    return std::bit_ceil(std::max(bytes, ALIGNMENT));
+}
+
+void *systemAllocate(size_t size, HugePages policy) {
+#ifdef __linux__
+    if (size >= HUGE_PAGE_SIZE) {
+        if (policy == HugePages::Explicit) {
+            auto p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) {
+                return p;
+            }
+        }
+
+        // Over-allocate to be able to align the start to a huge page boundary, which THP requires.
+        const size_t mapped = size + HUGE_PAGE_SIZE;
+        auto         p      = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            return nullptr;
+        }
+        const auto addr    = reinterpret_cast<uintptr_t>(p);
+        const auto aligned = (addr + HUGE_PAGE_SIZE - 1) & ~uintptr_t(HUGE_PAGE_SIZE - 1);
+        if (aligned > addr) {
+            munmap(p, aligned - addr);
+        }
+        const auto tail = addr + mapped - (aligned + size);
+        if (tail > 0) {
+            munmap(reinterpret_cast<void *>(aligned + size), tail);
+        }
+        if (policy != HugePages::Never) {
+            madvise(reinterpret_cast<void *>(aligned), size, MADV_HUGEPAGE);
+        }
+        return reinterpret_cast<void *>(aligned);
+    }
+#endif
+    return std::aligned_alloc(ALIGNMENT, size);
+}
+
+void systemFree(void *ptr, size_t size) {
+#ifdef __linux__
+    if (size >= HUGE_PAGE_SIZE) {
+        munmap(ptr, size);
+        return;
+    }
+#endif
+    std::free(ptr);
+}
+
+} // namespace
+
+void setHugePages(HugePages policy) {
+    auto            &p = pool();
+    std::scoped_lock lock(p.mutex);
+    p.hugePages = policy;
+}
+
+HugePages hugePages() {
+    auto            &p = pool();
+    std::scoped_lock lock(p.mutex);
+    return p.hugePages;
+}
+
+void setPoolLimit(size_t bytes) {
+    auto            &p = pool();
+    std::scoped_lock lock(p.mutex);
+    p.limit = bytes;
+    for (auto it = p.blocks.begin(); it != p.blocks.end() && p.pooledBytes > p.limit; ++it) {
+        while (!it->second.empty() && p.pooledBytes > p.limit) {
+            systemFree(it->second.back(), it->first);
+            it->second.pop_back();
+            p.pooledBytes -= it->first;
+        }
+    }
+}
+
+void *allocate(size_t bytes) {
+    const auto       size = blockSize(bytes);
+
+    auto            &p    = pool();
+    std::scoped_lock lock(p.mutex);
+    p.allocatedBytes += size;
+
+    auto it = p.blocks.find(size);
+    if (it != p.blocks.end() && !it->second.empty()) {
+        auto ptr = it->second.back();
+        it->second.pop_back();
+        p.pooledBytes -= size;
+        return ptr;
+    }
+
+    auto ptr = systemAllocate(size, p.hugePages);
+    if (!ptr) {
+        fmt::print(stderr, "Failed to allocate {} bytes of DataSet storage.\n", size);
+        p.allocatedBytes -= size;
+    }
+    return ptr;
+}
+
+void deallocate(void *ptr, size_t bytes) {
+    if (!ptr) {
+        return;
+    }
+    const auto       size = blockSize(bytes);
+
+    auto            &p    = pool();
+    std::scoped_lock lock(p.mutex);
+    p.allocatedBytes -= size;
+
+    if (p.pooledBytes + size > p.limit) {
+        systemFree(ptr, size);
+        return;
+    }
+    p.blocks[size].push_back(ptr);
+    p.pooledBytes += size;
+}
+
+size_t allocatedBytes() {
+    auto            &p = pool();
+    std::scoped_lock lock(p.mutex);
+    return p.allocatedBytes;
+}
+
+size_t pooledBytes() {
+    auto            &p = pool();
+    std::scoped_lock lock(p.mutex);
+    return p.pooledBytes;
+}
+
+} // namespace ImChart::Storage
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <vector>
+
+namespace ImChart {
+
+/**
+ * Backing memory for DataSet sample arrays.
+ *
+ * All blocks are aligned to Storage::ALIGNMENT so SIMD kernels can use aligned loads. Blocks of
+ * at least Storage::HUGE_PAGE_SIZE are mapped separately and, depending on the huge page policy,
+ * backed by transparent or explicit (MAP_HUGETLB) huge pages. Freed blocks are kept in a pool and
+ * handed out again when a DataSet is resized to a similar size.
+ */
+namespace Storage {
+
+constexpr size_t ALIGNMENT      = 64;
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+enum class HugePages {
+    Never,
+    Transparent, // madvise(MADV_HUGEPAGE), the kernel backs the mapping with huge pages when it can
+    Explicit     // mmap(MAP_HUGETLB), falls back to Transparent if no huge pages are reserved
+};
+
+void      setHugePages(HugePages policy);
+HugePages hugePages();
+
+// Upper bound of the memory kept in the pool, freed blocks beyond it are returned to the system
+void      setPoolLimit(size_t bytes);
+
+void     *allocate(size_t bytes);
+void      deallocate(void *ptr, size_t bytes);
+
+size_t    allocatedBytes();
+size_t    pooledBytes();
+
+} // namespace Storage
+
+template<typename T>
+class StorageAllocator {
+public:
+    using value_type                             = T;
+
+    StorageAllocator() noexcept                  = default;
+    template<typename U>
+    StorageAllocator(const StorageAllocator<U> &) noexcept {}
+
+    T *allocate(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        auto p = Storage::allocate(n * sizeof(T));
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(p);
+    }
+    void deallocate(T *p, size_t n) noexcept { Storage::deallocate(p, n * sizeof(T)); }
+
+    template<typename U>
+    bool operator==(const StorageAllocator<U> &) const noexcept { return true; }
+};
+
+using FloatStorage = std::vector<float, StorageAllocator<float>>;
+
+template<typename T>
+inline size_t memoryUsage(const std::vector<T, StorageAllocator<T>> &v) {
+    return v.capacity() * sizeof(T);
+}
+
+} // namespace ImChart
@@ -0,0 +1,400 @@
+#include "streamstatistics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <utility>
+
+#include "parallel.h"
+
+namespace ImChart {
+
+namespace {
+
+constexpr int LANES         = 8;
+// Values per chunk of Moments::add(), small enough to stay in L1 for the second pass
+constexpr int MOMENTS_CHUNK = 1024;
+// Values sorted and merged into a QuantileSketch at once
+constexpr int SKETCH_CHUNK  = 4096;
+constexpr int RADIX_BITS    = 11;
+
+// Order preserving mapping of the float bits: negative values reversed, and below the positive ones
+constexpr uint32_t sortKey(uint32_t bits) {
+    return bits ^ (uint32_t(int32_t(bits) >> 31) | 0x80000000u);
+}
+
+constexpr uint32_t fromSortKey(uint32_t key) {
+    return key ^ (((key >> 31) - 1) | 0x80000000u);
+}
+
+// Sorts the finite values, the ones Moments::add() counts, in three counting passes over 11 bit digits of the keys
+void radixSort(std::span<const float> values, std::vector<float> &sorted) {
+    thread_local std::vector<uint32_t> keys;
+    thread_local std::vector<uint32_t> buffer;
+    keys.clear();
+    for (const float v : values) {
+        if (std::isfinite(v)) {
+            keys.push_back(sortKey(std::bit_cast<uint32_t>(v)));
+        }
+    }
+    buffer.resize(keys.size());
+    for (int shift = 0; shift < 32; shift += RADIX_BITS) {
+        uint32_t offsets[1 << RADIX_BITS] = {};
+        for (const uint32_t k : keys) {
+            ++offsets[(k >> shift) & ((1 << RADIX_BITS) - 1)];
+        }
+        uint32_t sum = 0;
+        for (auto &o : offsets) {
+            sum += std::exchange(o, sum);
+        }
+        for (const uint32_t k : keys) {
+            buffer[offsets[(k >> shift) & ((1 << RADIX_BITS) - 1)]++] = k;
+        }
+        keys.swap(buffer);
+    }
+    sorted.resize(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        sorted[i] = std::bit_cast<float>(fromSortKey(keys[i]));
+    }
+}
+
+// The Moments of one chunk of at most MOMENTS_CHUNK values
+Moments chunkMoments(const float *v, int n) {
+    if (n == 0) {
+        return {};
+    }
+    const int m = n - n % LANES;
+
+    float     sum[LANES] = {};
+    float     lo[LANES];
+    float     hi[LANES];
+    std::fill_n(lo, LANES, std::numeric_limits<float>::max());
+    std::fill_n(hi, LANES, std::numeric_limits<float>::lowest());
+    for (int i = 0; i < m; i += LANES) {
+        for (int l = 0; l < LANES; ++l) {
+            sum[l] += v[i + l];
+            lo[l] = v[i + l] < lo[l] ? v[i + l] : lo[l];
+            hi[l] = v[i + l] > hi[l] ? v[i + l] : hi[l];
+        }
+    }
+    for (int i = m; i < n; ++i) {
+        sum[0] += v[i];
+        lo[0] = std::min(lo[0], v[i]);
+        hi[0] = std::max(hi[0], v[i]);
+    }
+
+    Moments chunk;
+    chunk.count = n;
+    for (int l = 0; l < LANES; ++l) {
+        chunk.mean += sum[l];
+        chunk.min = std::min(chunk.min, lo[l]);
+        chunk.max = std::max(chunk.max, hi[l]);
+    }
+    chunk.mean /= n;
+
+    // second pass over the chunk, still in cache, instead of the cancelling sum of squares
+    const float mean          = float(chunk.mean);
+    float       square[LANES] = {};
+    for (int i = 0; i < m; i += LANES) {
+        for (int l = 0; l < LANES; ++l) {
+            const float d = v[i + l] - mean;
+            square[l] += d * d;
+        }
+    }
+    for (int i = m; i < n; ++i) {
+        const float d = v[i] - mean;
+        square[0] += d * d;
+    }
+    for (int l = 0; l < LANES; ++l) {
+        chunk.m2 += square[l];
+    }
+    return chunk;
+}
+
+} // namespace
+
+void Moments::add(std::span<const float> values) {
+    for (size_t c = 0; c < values.size(); c += MOMENTS_CHUNK) {
+        const float *v     = values.data() + c;
+        const int    n     = int(std::min<size_t>(MOMENTS_CHUNK, values.size() - c));
+        Moments      chunk = chunkMoments(v, n);
+        if (!std::isfinite(chunk.mean)) {
+            // a gap (NaN) or an infinity in the chunk, compute it again over its finite values only
+            float     finite[MOMENTS_CHUNK];
+            const int count = int(std::copy_if(v, v + n, finite, [](float x) { return std::isfinite(x); }) - finite);
+            chunk           = chunkMoments(finite, count);
+        }
+        merge(chunk);
+    }
+}
+
+void Moments::merge(const Moments &other) {
+    if (other.count == 0) {
+        return;
+    }
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    const double n     = double(count + other.count);
+    const double delta = other.mean - mean;
+    mean += delta * double(other.count) / n;
+    m2 += other.m2 + delta * delta * double(count) * double(other.count) / n;
+    count += other.count;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+double Moments::stddev() const {
+    return std::sqrt(variance());
+}
+
+double Moments::rms() const {
+    return std::sqrt(mean * mean + variance());
+}
+
+void QuantileSketch::add(std::span<const float> values) {
+    thread_local std::vector<float>    sorted;
+    thread_local std::vector<Centroid> merged;
+    for (size_t c = 0; c < values.size(); c += SKETCH_CHUNK) {
+        const auto chunk = values.subspan(c, std::min<size_t>(SKETCH_CHUNK, values.size() - c));
+        radixSort(chunk, sorted);
+        if (sorted.empty()) {
+            continue;
+        }
+        m_min = std::min(m_min, sorted.front());
+        m_max = std::max(m_max, sorted.back());
+
+        merged.clear();
+        auto it = m_centroids.begin();
+        for (const float v : sorted) {
+            for (; it != m_centroids.end() && it->mean < v; ++it) {
+                merged.push_back(*it);
+            }
+            merged.push_back({ v, 1 });
+        }
+        merged.insert(merged.end(), it, m_centroids.end());
+        m_count += int64_t(sorted.size());
+        compress(merged);
+    }
+}
+
+void QuantileSketch::merge(const QuantileSketch &other) {
+    if (other.m_count == 0) {
+        return;
+    }
+    thread_local std::vector<Centroid> merged;
+    merged.resize(m_centroids.size() + other.m_centroids.size());
+    std::merge(m_centroids.begin(), m_centroids.end(), other.m_centroids.begin(), other.m_centroids.end(), merged.begin(),
+            [](const Centroid &a, const Centroid &b) { return a.mean < b.mean; });
+    m_count += other.m_count;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+    compress(merged);
+}
+
+void QuantileSketch::clear() {
+    m_centroids.clear();
+    m_count = 0;
+    m_min   = std::numeric_limits<float>::max();
+    m_max   = std::numeric_limits<float>::lowest();
+}
+
+void QuantileSketch::compress(const std::vector<Centroid> &sorted) {
+    m_centroids.clear();
+    if (sorted.empty()) {
+        return;
+    }
+    const double total   = double(m_count);
+    Centroid     current = sorted.front();
+    double       before  = 0;
+    for (size_t i = 1; i < sorted.size(); ++i) {
+        const auto   &next   = sorted[i];
+        const int64_t weight = current.weight + next.weight;
+        const double  q      = (before + weight / 2.) / total;
+        if (double(weight) <= 4 * total * q * (1 - q) / COMPRESSION) {
+            current.mean += (next.mean - current.mean) * double(next.weight) / double(weight);
+            current.weight = weight;
+        } else {
+            m_centroids.push_back(current);
+            before += double(current.weight);
+            current = next;
+        }
+    }
+    m_centroids.push_back(current);
+}
+
+float QuantileSketch::quantile(double q) const {
+    if (m_count == 0) {
+        return std::numeric_limits<float>::quiet_NaN();
+    }
+    if (m_centroids.size() == 1) {
+        return float(m_centroids.front().mean);
+    }
+    // the centroids sit at the middle of their weight, the ends are the min and max
+    const double target = std::clamp(q, 0., 1.) * double(m_count);
+    double       center = double(m_centroids.front().weight) / 2;
+    if (target < center) {
+        return float(m_min + (m_centroids.front().mean - m_min) * target / center);
+    }
+    for (size_t i = 0; i + 1 < m_centroids.size(); ++i) {
+        const auto  &a    = m_centroids[i];
+        const auto  &b    = m_centroids[i + 1];
+        const double next = center + double(a.weight + b.weight) / 2;
+        if (target < next) {
+            return float(a.mean + (b.mean - a.mean) * (target - center) / (next - center));
+        }
+        center = next;
+    }
+    const double rest = double(m_count) - center;
+    return float(m_centroids.back().mean + (m_max - m_centroids.back().mean) * std::min(1., (target - center) / rest));
+}
+
+void StreamStatistics::Statistics::add(std::span<const float> values) {
+    moments.add(values);
+    quantiles.add(values);
+}
+
+void StreamStatistics::Statistics::merge(const Statistics &other) {
+    moments.merge(other.moments);
+    quantiles.merge(other.quantiles);
+}
+
+StreamStatistics::StreamStatistics(DataSet &dataSet, int dimIndex, int window)
+    : m_dataSet(dataSet)
+    , m_dimIndex(dimIndex)
+    , m_window(std::max(0, window)) {
+    m_listenerId = m_dataSet.addDataChangedListener([this](int start, int count) { dataChanged(start, count); });
+    if (m_dataSet.isReady()) {
+        dataChanged(0, m_dataSet.getDataCount());
+    }
+}
+
+StreamStatistics::~StreamStatistics() {
+    m_dataSet.removeDataChangedListener(m_listenerId);
+}
+
+void StreamStatistics::dataChanged(int start, int count) {
+    const int n      = m_dataSet.getDataCount();
+    const int blocks = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    start            = std::clamp(start, 0, n);
+    int first        = start / BLOCK_SIZE;
+    int last         = (std::clamp(start + std::max(count, 0), 0, n) + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    if (n > m_dataCount) {
+        // the previous last block was partial, the new values follow it
+        first = std::min(first, m_dataCount / BLOCK_SIZE);
+        last  = blocks;
+    } else if (n < m_dataCount) {
+        // the new last block lost values
+        first = std::min(first, std::max(blocks - 1, 0));
+        last  = blocks;
+    }
+    m_dataCount = n;
+    m_blocks.resize(blocks);
+    last = std::min(last, blocks);
+
+    if (first < last) {
+        recompute(first, last);
+    }
+    if (first < m_sealed) {
+        m_sealed = 0;
+        m_prefix = {};
+    }
+    m_dirty = true;
+}
+
+void StreamStatistics::recompute(int first, int last) {
+    const auto values = m_dataSet.getValues(m_dimIndex);
+    const auto block  = [&](int b) {
+        const size_t begin = size_t(b) * BLOCK_SIZE;
+        return std::make_pair(begin, std::min<size_t>(begin + BLOCK_SIZE, m_dataCount));
+    };
+
+    if (values.size() >= size_t(m_dataCount)) {
+        parallelFor(last - first, 4, [&](size_t begin, size_t end, int) {
+            for (size_t b = first + begin; b < first + end; ++b) {
+                const auto [from, to] = block(int(b));
+                m_blocks[b]           = {};
+                m_blocks[b].add(values.subspan(from, to - from));
+            }
+        }, "stream statistics");
+        return;
+    }
+    // data sets without contiguous values
+    for (int b = first; b < last; ++b) {
+        const auto [from, to] = block(b);
+        m_scratch.resize(to - from);
+        for (size_t i = from; i < to; ++i) {
+            m_scratch[i - from] = m_dataSet.get(m_dimIndex, int(i));
+        }
+        m_blocks[b] = {};
+        m_blocks[b].add(m_scratch);
+    }
+}
+
+void StreamStatistics::refresh() const {
+    if (!m_dirty) {
+        return;
+    }
+    m_dirty = false;
+
+    // every block but the last one is full, and stays unchanged for a data set growing at its end
+    while (m_sealed + 1 < int(m_blocks.size())) {
+        m_prefix.merge(m_blocks[m_sealed++]);
+    }
+    m_total = m_prefix;
+    for (int b = m_sealed; b < int(m_blocks.size()); ++b) {
+        m_total.merge(m_blocks[b]);
+    }
+    m_totalSummary = summarize(m_total);
+
+    if (m_window > 0) {
+        Statistics window;
+        for (int b = std::max(0, m_dataCount - m_window) / BLOCK_SIZE; b < int(m_blocks.size()); ++b) {
+            window.merge(m_blocks[b]);
+        }
+        m_windowSummary = summarize(window);
+    }
+}
+
+StreamStatistics::Summary StreamStatistics::summarize(const Statistics &statistics) {
+    const auto &m = statistics.moments;
+    Summary     s;
+    if (m.count == 0) {
+        return s;
+    }
+    s.count  = m.count;
+    s.mean   = m.mean;
+    s.rms    = m.rms();
+    s.stddev = m.stddev();
+    s.min    = m.min;
+    s.max    = m.max;
+    s.p1     = statistics.quantiles.quantile(0.01);
+    s.p99    = statistics.quantiles.quantile(0.99);
+    return s;
+}
+
+const StreamStatistics::Summary &StreamStatistics::total() const {
+    refresh();
+    return m_totalSummary;
+}
+
+const StreamStatistics::Summary &StreamStatistics::window() const {
+    refresh();
+    return m_windowSummary;
+}
+
+float StreamStatistics::quantile(double q) const {
+    refresh();
+    return m_total.quantiles.quantile(q);
+}
+
+size_t StreamStatistics::memoryUsage() const {
+    size_t bytes = m_blocks.capacity() * sizeof(Statistics) + m_prefix.quantiles.memoryUsage() + m_total.quantiles.memoryUsage();
+    for (const auto &b : m_blocks) {
+        bytes += b.quantiles.memoryUsage();
+    }
+    return bytes;
+}
+
+} // namespace ImChart
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include <dataset.h>
+
+namespace ImChart {
+
+/**
+ * Count, mean, variance, min and max of a set of values. add() folds the values in chunks, with
+ * the sums and extremes of each chunk computed over 8 lanes so the loops vectorize, and merges
+ * every chunk with the pairwise update of Chan et al., which keeps the variance accurate for
+ * values far from 0. Two Moments of disjoint sets merge into the Moments of their union. Only the
+ * finite values are counted, NaN gaps and infinities are skipped.
+ */
+struct Moments {
+    int64_t count = 0;
+    double  mean  = 0;
+    double  m2    = 0; // sum of the squared differences to the mean
+    float   min   = std::numeric_limits<float>::max();
+    float   max   = std::numeric_limits<float>::lowest();
+
+    void    add(std::span<const float> values);
+    void    merge(const Moments &other);
+
+    double  variance() const { return count > 0 ? m2 / double(count) : 0; }
+    double  stddev() const;
+    double  rms() const;
+};
+
+/**
+ * Mergeable quantile sketch, a merging t-digest: the values are kept as weighted centroids, sorted
+ * by their mean, whose weight is limited to 4 * count * q * (1 - q) / COMPRESSION at their
+ * quantile q. Centroids near the ends stay small, so extreme quantiles like p1 and p99 are the most
+ * accurate, independent of the offset and scale of the values. add() radix sorts the new values
+ * and merges them with the centroids in one pass, merge() does the same with the centroids of
+ * another sketch, so the sketches of blocks of values merge into the sketch of all of them.
+ */
+class QuantileSketch {
+public:
+    static constexpr int COMPRESSION = 100;
+
+    void                 add(std::span<const float> values);
+    void                 merge(const QuantileSketch &other);
+    void                 clear();
+
+    int64_t              count() const { return m_count; }
+    // The value at quantile 'q' in [0, 1], interpolated between the centroids, NaN if empty
+    float                quantile(double q) const;
+
+    size_t               memoryUsage() const { return m_centroids.capacity() * sizeof(Centroid); }
+
+private:
+    struct Centroid {
+        double  mean;
+        int64_t weight;
+    };
+
+    void                  compress(const std::vector<Centroid> &sorted);
+
+    std::vector<Centroid> m_centroids;
+    int64_t               m_count = 0;
+    float                 m_min   = std::numeric_limits<float>::max();
+    float                 m_max   = std::numeric_limits<float>::lowest();
+};
+
+/**
+ * Running statistics of one dimension of a data set, maintained from its dataChanged() ranges.
+ *
+ * The values are summarized in blocks of BLOCK_SIZE points, each with its Moments and
+ * QuantileSketch. A change only recomputes the blocks it touches, in parallel when there are many,
+ * and the totals merge the block summaries: the blocks before the last one are folded into a
+ * prefix once, so a data set growing at its end costs one block per update. With a window, the
+ * statistics over the last 'window' points are kept as well, rounded up to whole blocks.
+ *
+ * Reading the statistics never touches the values of the data set.
+ */
+class StreamStatistics {
+public:
+    static constexpr int BLOCK_SIZE = 4096;
+
+    struct Summary {
+        int64_t count  = 0;
+        double  mean   = 0;
+        double  rms    = 0;
+        double  stddev = 0;
+        float   min    = 0;
+        float   max    = 0;
+        float   p1     = 0;
+        float   p99    = 0;
+    };
+
+    explicit StreamStatistics(DataSet &dataSet, int dimIndex = 1, int window = 0);
+    ~StreamStatistics();
+
+    StreamStatistics(const StreamStatistics &) = delete;
+    StreamStatistics &operator=(const StreamStatistics &) = delete;
+
+    const Summary    &total() const;
+    const Summary    &window() const;
+    // The quantile 'q' over all values, see QuantileSketch::quantile()
+    float             quantile(double q) const;
+
+    size_t            memoryUsage() const;
+
+private:
+    struct Statistics {
+        Moments        moments;
+        QuantileSketch quantiles;
+
+        void           add(std::span<const float> values);
+        void           merge(const Statistics &other);
+    };
+
+    void                    dataChanged(int start, int count);
+    void                    recompute(int first, int last);
+    void                    refresh() const;
+    static Summary          summarize(const Statistics &statistics);
+
+    DataSet                &m_dataSet;
+    const int               m_dimIndex;
+    const int               m_window;
+    int                     m_listenerId;
+    int                     m_dataCount = 0;
+    std::vector<Statistics> m_blocks;
+    std::vector<float>      m_scratch;
+
+    // blocks [0, m_sealed) merged, they are only merged again after a change touched them
+    mutable int             m_sealed = 0;
+    mutable Statistics      m_prefix;
+    mutable Statistics      m_total;
+    mutable Summary         m_totalSummary;
+    mutable Summary         m_windowSummary;
+    mutable bool            m_dirty = true;
+};
+
+} // namespace ImChart
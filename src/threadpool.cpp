@@ -0,0 +1,169 @@
+#include "threadpool.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ImChart {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// The pool and queue index of the worker running on this thread
+thread_local const ThreadPool *t_pool   = nullptr;
+thread_local int               t_worker = -1;
+
+} // namespace
+
+ThreadPool::ThreadPool(int workers) {
+    m_workers.resize(std::max(1, workers));
+    for (auto &w : m_workers) {
+        w = std::make_unique<Worker>();
+    }
+    for (int i = 0; i < int(m_workers.size()); ++i) {
+        m_workers[i]->thread = std::thread([this, i]() { run(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(m_sleepMutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (auto &w : m_workers) {
+        w->thread.join();
+    }
+}
+
+void ThreadPool::submit(const char *name, Task task) {
+    const int self  = currentWorker();
+    const int index = self >= 0 ? self : int(m_nextQueue++ % m_workers.size());
+    {
+        auto           &worker = *m_workers[index];
+        std::lock_guard lock(worker.mutex);
+        worker.tasks.push_back({ name, std::move(task) });
+    }
+    ++m_queued;
+    // taking the lock orders the wake up after the check of a worker about to sleep
+    { std::lock_guard lock(m_sleepMutex); }
+    m_wake.notify_one();
+}
+
+bool ThreadPool::runOne(int self) {
+    Item       item;
+    bool       found = false;
+    const int  n     = int(m_workers.size());
+    if (self >= 0) {
+        auto           &own = *m_workers[self];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+            item = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+    for (int k = 1; k <= n && !found; ++k) {
+        auto           &victim = *m_workers[(std::max(self, 0) + k) % n];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            item = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            found = true;
+        }
+    }
+    if (!found) {
+        return false;
+    }
+    --m_queued;
+
+    const auto start = Clock::now();
+    item.task();
+    if (item.name) {
+        record(item.name, Clock::now() - start);
+    }
+    return true;
+}
+
+int ThreadPool::currentWorker() const {
+    return t_pool == this ? t_worker : -1;
+}
+
+void ThreadPool::run(int index) {
+    t_pool   = this;
+    t_worker = index;
+    for (;;) {
+        if (runOne(index)) {
+            continue;
+        }
+        std::unique_lock lock(m_sleepMutex);
+        m_wake.wait(lock, [this]() { return m_quit || m_queued > 0; });
+        if (m_quit) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::parallelFor(const char *name, size_t count, size_t minChunk, const std::function<void(size_t begin, size_t end, int chunk)> &fn) {
+    if (count == 0) {
+        return;
+    }
+    const auto start  = Clock::now();
+    const int  chunks = chunkCount(count, minChunk);
+    if (chunks == 1) {
+        fn(0, count, 0);
+    } else {
+        // Helpers and the caller claim chunks until all are taken. A helper which only starts
+        // after that returns right away, without touching 'fn'.
+        struct State {
+            std::atomic<int> next      = 0;
+            std::atomic<int> remaining = 0;
+        };
+        auto         state = std::make_shared<State>();
+        const size_t size  = (count + chunks - 1) / chunks;
+        state->remaining   = chunks;
+        const auto work    = [state, &fn, count, chunks, size]() {
+            for (int c; (c = state->next++) < chunks;) {
+                const size_t begin = std::min(count, c * size);
+                fn(begin, std::min(count, begin + size), c);
+                if (--state->remaining == 0) {
+                    state->remaining.notify_all();
+                }
+            }
+        };
+        for (int i = 1; i < chunks; ++i) {
+            submit(nullptr, work);
+        }
+        work();
+        for (int r; (r = state->remaining) > 0;) {
+            state->remaining.wait(r);
+        }
+    }
+    if (name) {
+        record(name, Clock::now() - start);
+    }
+}
+
+int ThreadPool::chunkCount(size_t count, size_t minChunk) const {
+    return int(std::clamp<size_t>(count / std::max<size_t>(minChunk, 1), 1, m_workers.size() + 1));
+}
+
+void ThreadPool::record(const char *name, std::chrono::nanoseconds time) {
+    std::lock_guard lock(m_statsMutex);
+    auto            it = std::find_if(m_stats.begin(), m_stats.end(), [name](const TaskStats &s) {
+        return s.name == name || std::strcmp(s.name, name) == 0;
+    });
+    if (it == m_stats.end()) {
+        it = m_stats.insert(m_stats.end(), { name });
+    }
+    ++it->count;
+    it->total += time;
+    it->max = std::max(it->max, time);
+}
+
+std::vector<ThreadPool::TaskStats> ThreadPool::stats() const {
+    std::lock_guard lock(m_statsMutex);
+    return m_stats;
+}
+
+} // namespace ImChart
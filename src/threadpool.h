@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ImChart {
+
+/**
+ * Work-stealing thread pool shared by all background computations, see Backend::threadPool().
+ *
+ * Every worker has its own task queue. Tasks submitted from a worker go to its queue and are run
+ * newest first, which keeps nested work hot in the cache; idle workers steal the oldest tasks of
+ * the others. Tasks submitted from other threads are spread over the queues.
+ *
+ * Tasks must not block waiting for other tasks, except through parallelFor(), whose caller runs
+ * the chunks itself if no worker is free. Blocking work like file or socket I/O belongs on a
+ * dedicated thread.
+ *
+ * The run time of named tasks is accumulated per name, see stats().
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    struct TaskStats {
+        const char              *name;
+        uint64_t                 count = 0;
+        std::chrono::nanoseconds total = {};
+        std::chrono::nanoseconds max   = {};
+    };
+
+    explicit ThreadPool(int workers);
+    ~ThreadPool();
+
+    int                    workerCount() const { return int(m_workers.size()); }
+
+    // 'name' must be a string literal, or nullptr to not account the task
+    void                   submit(const char *name, Task task);
+
+    // Like std::async, but running on the pool
+    template<typename F>
+    auto                   async(const char *name, F &&f) -> std::future<std::invoke_result_t<std::decay_t<F>>>;
+
+    /**
+     * Splits [0, count) in at most workerCount() + 1 chunks of at least 'minChunk' elements and runs
+     * them in parallel, the calling thread included, blocking until all are done. 'chunk' is unique
+     * among the chunks of one call, so it can index per-chunk scratch buffers.
+     */
+    void                   parallelFor(const char *name, size_t count, size_t minChunk, const std::function<void(size_t begin, size_t end, int chunk)> &fn);
+    // Number of chunks parallelFor() splits [0, count) in, 'chunk' is below it
+    int                    chunkCount(size_t count, size_t minChunk) const;
+
+    // Waits for the result of async(). On a worker, runs other tasks meanwhile instead of blocking.
+    template<typename T>
+    T                      get(std::future<T> &future);
+
+    // Per task name statistics, parallelFor() calls count as one task each
+    std::vector<TaskStats> stats() const;
+
+private:
+    struct Item {
+        const char *name;
+        Task        task;
+    };
+
+    struct Worker {
+        std::mutex       mutex;
+        std::deque<Item> tasks;
+        std::thread      thread;
+    };
+
+    void                                 run(int index);
+    bool                                 runOne(int self);
+    // The queue index if called from one of the workers, -1 otherwise
+    int                                  currentWorker() const;
+    void                                 record(const char *name, std::chrono::nanoseconds time);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<int>                     m_queued    = 0;
+    std::atomic<unsigned>                m_nextQueue = 0;
+    std::mutex                           m_sleepMutex;
+    std::condition_variable              m_wake;
+    bool                                 m_quit = false;
+
+    mutable std::mutex                   m_statsMutex;
+    std::vector<TaskStats>               m_stats;
+};
+
+template<typename F>
+auto ThreadPool::async(const char *name, F &&f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+    using Result = std::invoke_result_t<std::decay_t<F>>;
+    auto task    = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+    auto future  = task->get_future();
+    submit(name, [task]() { (*task)(); });
+    return future;
+}
+
+template<typename T>
+T ThreadPool::get(std::future<T> &future) {
+    if (const int self = currentWorker(); self >= 0) {
+        while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            if (!runOne(self)) {
+                future.wait_for(std::chrono::microseconds(100));
+            }
+        }
+    }
+    return future.get();
+}
+
+} // namespace ImChart
@@ -0,0 +1,57 @@
+#include "transform.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ImChart {
+
+AxisTransform AxisTransform::linear(float min, float max, float pixelMin, float pixelMax) {
+    AxisTransform t;
+    t.m_min    = min;
+    t.m_max    = max;
+    t.m_scale  = (pixelMax - pixelMin) / (max - min);
+    t.m_offset = pixelMin - min * t.m_scale;
+    return t;
+}
+
+AxisTransform AxisTransform::log(float min, float max, float pixelMin, float pixelMax) {
+    AxisTransform t;
+    t.m_min    = std::max(min, std::numeric_limits<float>::min());
+    t.m_max    = std::max(max, t.m_min);
+    t.m_log    = true;
+    t.m_scale  = (pixelMax - pixelMin) / (std::log2(t.m_max) - std::log2(t.m_min));
+    t.m_offset = pixelMin - std::log2(t.m_min) * t.m_scale;
+    return t;
+}
+
+float AxisTransform::toPixel(float value) const {
+    toPixels(&value, 1, &value);
+    return value;
+}
+
+float AxisTransform::fromPixel(float pixel) const {
+    const float v = (pixel - m_offset) / m_scale;
+    return m_log ? std::exp2(v) : v;
+}
+
+void AxisTransform::toPixels(const float *values, int count, float *pixels) const {
+    const float scale  = m_scale;
+    const float offset = m_offset;
+    if (!m_log) {
+        for (int i = 0; i < count; ++i) {
+            pixels[i] = values[i] * scale + offset;
+        }
+        return;
+    }
+    // Non-positive values are clamped to the smallest normal float, far off the plot. The clamp
+    // works on the bits: negative floats are negative integers, and unlike a float comparison the
+    // integer one does not keep the loop from vectorizing.
+    constexpr int32_t smallest = 0x00800000;
+    for (int i = 0; i < count; ++i) {
+        int32_t bits = std::bit_cast<int32_t>(values[i]);
+        bits         = bits > smallest ? bits : smallest;
+        pixels[i]    = fastLog2(std::bit_cast<float>(bits)) * scale + offset;
+    }
+}
+
+} // namespace ImChart
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+namespace ImChart {
+
+/**
+ * log2() for batched transforms: splits the float into exponent and mantissa and evaluates a
+ * series for the logarithm of the mantissa. There are no branches and no library calls, so loops
+ * over it vectorize. The absolute error is below 3e-5. Non-positive values give garbage, callers
+ * clamp them first.
+ */
+inline float fastLog2(float v) {
+    const uint32_t bits = std::bit_cast<uint32_t>(v);
+    const float    e    = float(int32_t(bits >> 23) - 127);
+    const float    m    = std::bit_cast<float>((bits & 0x007fffffu) | 0x3f800000u); // [1, 2)
+    // log(m) = 2 atanh(y), with y = (m - 1) / (m + 1) in [0, 1/3)
+    const float    y    = (m - 1.f) / (m + 1.f);
+    const float    y2   = y * y;
+    const float    s    = y * (1.f + y2 * (1.f / 3.f + y2 * (1.f / 5.f + y2 * (1.f / 7.f))));
+    return e + s * 2.8853900817779268f; // 2 / ln(2)
+}
+
+/**
+ * Maps the values of one plot axis to pixels, linearly or logarithmically.
+ *
+ * toPixels() transforms whole arrays in one loop without per-value branches or library calls, so
+ * projecting large series vectorizes and runs at memory bandwidth.
+ */
+class AxisTransform {
+public:
+    AxisTransform() = default;
+    // Maps [min, max] to [pixelMin, pixelMax], which can be decreasing, e.g. for y axes
+    static AxisTransform linear(float min, float max, float pixelMin, float pixelMax);
+    static AxisTransform log(float min, float max, float pixelMin, float pixelMax);
+
+    bool                 operator==(const AxisTransform &) const = default;
+
+    float                min() const { return m_min; }
+    float                max() const { return m_max; }
+    bool                 isLog() const { return m_log; }
+
+    float                toPixel(float value) const;
+    float                fromPixel(float pixel) const;
+    void                 toPixels(const float *values, int count, float *pixels) const;
+
+private:
+    float m_min    = 0;
+    float m_max    = 1;
+    bool  m_log    = false;
+    // pixel = (value or log2(value)) * m_scale + m_offset
+    float m_scale  = 1;
+    float m_offset = 0;
+};
+
+} // namespace ImChart
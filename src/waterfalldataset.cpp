@@ -0,0 +1,62 @@
+#include "waterfalldataset.h"
+
+#include <algorithm>
+
+namespace ImChart {
+
+WaterfallDataSet::WaterfallDataSet(int width, int depth)
+    : m_width(std::max(1, width))
+    , m_depth(std::max(1, depth)) {
+    _xdata.resize(m_width);
+    _ydata.resize(m_depth);
+    _zdata.resize(size_t(m_width) * m_depth);
+    for (int i = 0; i < m_width; ++i) {
+        _xdata[i] = float(i);
+    }
+    for (int i = 0; i < m_depth; ++i) {
+        _ydata[i] = float(i);
+    }
+}
+
+WaterfallDataSet::~WaterfallDataSet() {
+}
+
+float WaterfallDataSet::get(int dimIndex, int index) const {
+    return (dimIndex == 0 ? _xdata : dimIndex == 1 ? _ydata : _zdata)[index];
+}
+
+std::span<float> WaterfallDataSet::getValues(int dimIndex) {
+    return dimIndex == 0 ? _xdata : (dimIndex == 1 ? _ydata : _zdata);
+}
+
+size_t WaterfallDataSet::memoryUsage() const {
+    return ImChart::memoryUsage(_xdata) + ImChart::memoryUsage(_ydata) + ImChart::memoryUsage(_zdata);
+}
+
+int WaterfallDataSet::ringRow(int age) const {
+    return int((m_rowsWritten - 1 - age) % m_depth);
+}
+
+std::span<const float> WaterfallDataSet::row(int age) const {
+    if (age < 0 || uint64_t(age) >= std::min<uint64_t>(m_rowsWritten, m_depth)) {
+        return {};
+    }
+    return { _zdata.data() + size_t(ringRow(age)) * m_width, size_t(m_width) };
+}
+
+void WaterfallDataSet::setXValues(std::span<const float> xs) {
+    std::copy_n(xs.begin(), std::min<size_t>(xs.size(), m_width), _xdata.begin());
+    dataChanged(0, getDataCount());
+}
+
+void WaterfallDataSet::appendRow(std::span<const float> values) {
+    const int r     = int(m_rowsWritten % m_depth);
+    auto      dst   = _zdata.begin() + size_t(r) * m_width;
+    const int count = int(std::min<size_t>(values.size(), m_width));
+    std::copy_n(values.begin(), count, dst);
+    std::fill(dst + count, dst + m_width, 0.f);
+    ++m_rowsWritten;
+    dataChanged(r * m_width, m_width);
+}
+
+} // namespace ImChart
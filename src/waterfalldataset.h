@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+#include "storage.h"
+#include <dataset.h>
+
+namespace ImChart {
+
+/**
+ * Spectrogram/waterfall history: a ring of 'depth' rows of 'width' values each.
+ *
+ * appendRow() overwrites the oldest row, so appending costs O(width) no matter how deep the
+ * history is, and emits dataChanged() for the overwritten row only. Dimension 0 holds the x
+ * values of the columns, dimension 1 the row ages (0 is the newest row) and dimension 2 the ring
+ * storage as it is laid out in memory, i.e. ring row r starts at index r * width. Use ringRow()
+ * to map a row age to its ring row.
+ */
+class WaterfallDataSet : public DataSet {
+public:
+    WaterfallDataSet(int width, int depth);
+    ~WaterfallDataSet();
+
+    float                  get(int dimIndex, int index) const final;
+    int                    getDataCount() const final { return m_width * m_depth; }
+    int                    getDimension() const final { return 3; }
+    std::span<float>       getValues(int dimIndex) final;
+
+    size_t                 memoryUsage() const final;
+
+    int                    width() const { return m_width; }
+    int                    depth() const { return m_depth; }
+    // Total number of rows appended so far, the newest row is number rowsWritten() - 1
+    uint64_t               rowsWritten() const { return m_rowsWritten; }
+    int                    ringRow(int age) const;
+    std::span<const float> row(int age) const;
+
+    void                   setXValues(std::span<const float> xs);
+    void                   appendRow(std::span<const float> values);
+
+private:
+    int          m_width;
+    int          m_depth;
+    uint64_t     m_rowsWritten = 0;
+    FloatStorage _xdata;
+    FloatStorage _ydata;
+    FloatStorage _zdata;
+};
+
+} // namespace ImChart
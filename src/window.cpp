@@ -41,4 +41,10 @@ void Window::render() {
     onRender();
 }
 
+void Window::frameRendered() {
+    if (onFrameRendered) {
+        onFrameRendered();
+    }
+}
+
 } // namespace ImChart
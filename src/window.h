@@ -28,6 +28,9 @@ public:
     void                      scheduleRender();
     void                      render();
     std::function<void()>     onRender;
+    // Called after ImGui::Render(), while ImGui::GetDrawData() holds the frame
+    void                      frameRendered();
+    std::function<void()>     onFrameRendered;
 
     inline Backend::Window   &backendWindow() const { return *m_window; }
     inline Renderer::Surface &surface() const { return *m_surface; }